@@ -2,8 +2,15 @@
 
 #pragma once
 
+#include "VerletClothCore.h"
 #include "VerletClothComponent.generated.h"
 
+class FVerletClothDynamicDataPool;
+class FVerletClothSolver;
+class FVerletClothWindField;
+struct FVerletClothDynamicData;
+struct FVerletClothSnapshotParams;
+
 UENUM(BlueprintType)
 enum class ESideAxis : uint8
 {
@@ -21,185 +28,133 @@ enum class ECollisionPlane : uint8
 	ZX,
 };
 
-/** Struct containing information about a point along the cable */
-struct FVerletClothHorizontalLine
+UENUM(BlueprintType)
+enum class EVerletClothShapeType : uint8
+{
+	Sphere = 0,
+	Capsule,
+	Box,
+};
+
+/** Collision shape the cloth is kept out of */
+USTRUCT(BlueprintType)
+struct FVerletClothCollisionShape
 {
-	FVerletClothHorizontalLine()
-	: bFree(true), Damping(0.0f)
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth")
+	EVerletClothShapeType Type;
+
+	/** Bone or socket of the attach parent the shape follows, none to follow the component */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth")
+	FName SocketName;
+
+	/** Placement relative to the socket or the component */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth")
+	FVector Location;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth")
+	FRotator Rotation;
+
+	/** Radius of spheres and capsules */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth", meta = (ClampMin = "0.0"))
+	float Radius;
+
+	/** Half length of the capsule's inner segment, along Z */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth", meta = (ClampMin = "0.0"))
+	float HalfLength;
+
+	/** Half size of boxes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth")
+	FVector BoxExtent;
+
+	FVerletClothCollisionShape()
+	: Type(EVerletClothShapeType::Sphere), SocketName(NAME_None), Location(FVector::ZeroVector), Rotation(FRotator::ZeroRotator)
+	, Radius(10.0f), HalfLength(20.0f), BoxExtent(10.0f)
 	{}
+};
 
-	void SetHorizontal(const int32& NumSides, const float& Width)
-	{
-		HorizontalWidth = Width;
-		int32 NewSides = FMath::Max(1, NumSides);
-		Acceleration.AddZeroed(NewSides + 1);
-		Positions.AddZeroed(NewSides + 1);
-		SavedPositions.AddZeroed(NewSides + 1);
-	}
-
-	void SetInitPosition(const FVector& CenterLocation, const FVector& RelativeLocation, const FVector& SideVector)
-	{
-		if (Positions.Num() > 1)
-		{
-			int32 NumSides = Positions.Num() - 1;
-			FVector HorizontalStart = SideVector * (-HorizontalWidth / 2.0f);
-			FVector HorizontalDelta = SideVector * (HorizontalWidth / NumSides);
-			for (int32 Idx = 0; Idx < Positions.Num(); ++Idx)
-			{
-				Positions[Idx] = CenterLocation + (HorizontalStart + (HorizontalDelta * Idx));
-				if (bFree)
-					SavedPositions[Idx] = Positions[Idx];
-				else
-					SavedPositions[Idx] = RelativeLocation;
-			}
-		}
-	}
-
-	void VerletProcess(float InSubstepTime)
-	{
-		for (int32 Idx = 0; Idx < Positions.Num(); ++Idx)
-		{
-			const FVector Vel = (Positions[Idx] - SavedPositions[Idx]);
-			FVector NewPosition = Positions[Idx] + Vel * (1.0f - Damping) + (InSubstepTime * Acceleration[Idx]);
-			SavedPositions[Idx] = Positions[Idx];
-			Positions[Idx] = NewPosition;
-		}
-	}
-
-	void FixedProcess(const FVector& CenterLocation, const FVector& SideVector)
-	{
-		if (Positions.Num() > 1)
-		{
-			int32 NumSides = Positions.Num() - 1;
-			FVector HorizontalStart = SideVector * (-HorizontalWidth / 2.0f);
-			FVector HorizontalDelta = SideVector * (HorizontalWidth / NumSides);
-			for (int32 Idx = 0; Idx < Positions.Num(); ++Idx)
-				Positions[Idx] = CenterLocation + (HorizontalStart + (HorizontalDelta * Idx)) + SavedPositions[Idx];
-		}
-	}
-
-	void UpdateAcceleration(FVerletClothHorizontalLine& NextLine, const FVector& Gravity, const FVector& Wind, bool bLastSegment)
-	{
-		bool bNoWind = Wind.IsNearlyZero();
-		for (int32 Idx = 0; Idx < Positions.Num(); ++Idx)
-			Acceleration[Idx] = Gravity;
-
-		for (int32 Idx = 0; Idx < Positions.Num() - 1; ++Idx)
-		{
-			if (bNoWind)
-				break;
-
-			FVector First = Positions[Idx + 1] - Positions[Idx];
-			FVector Second = NextLine.Positions[Idx] - Positions[Idx];
-			FVector Normal = FVector::CrossProduct(First, Second).GetSafeNormal();
-			Acceleration[Idx] += (Normal * FVector::DotProduct(Normal, Wind));
-
-			First = NextLine.Positions[Idx + 1] - Positions[Idx + 1];
-			Second = Positions[Idx] - Positions[Idx + 1];
-			Normal = FVector::CrossProduct(First, Second).GetSafeNormal();
-			Acceleration[Idx+1] += (Normal * FVector::DotProduct(Normal, Wind));
-		}
-
-		if (bLastSegment)
-		{
-			for (int32 Idx = 0; Idx < NextLine.Positions.Num(); ++Idx)
-				NextLine.Acceleration[Idx] = Gravity;
-
-			for (int32 Idx = 0; Idx < NextLine.Positions.Num() - 1; ++Idx)
-			{
-				if (bNoWind)
-					break;
-
-				FVector First = Positions[Idx] - NextLine.Positions[Idx];
-				FVector Second = NextLine.Positions[Idx + 1] - NextLine.Positions[Idx];
-				FVector Normal = FVector::CrossProduct(First, Second).GetSafeNormal();
-				NextLine.Acceleration[Idx] += (Normal * FVector::DotProduct(Normal, Wind));
-
-				First = NextLine.Positions[Idx] - NextLine.Positions[Idx + 1];
-				Second = Positions[Idx + 1] - NextLine.Positions[Idx + 1];
-				Normal = FVector::CrossProduct(First, Second).GetSafeNormal();
-				NextLine.Acceleration[Idx + 1] += (Normal * FVector::DotProduct(Normal, Wind));
-			}
-		}
-	}
-
-	void SolveConstraints(FVerletClothHorizontalLine& NextLine, float SegmentLength, float DiagonalLength)
-	{
-		SolveHorizontalConstraint();
-		SolveVerticalConstraint(NextLine, SegmentLength);
-		SolveDiagonalConstraint1(NextLine, DiagonalLength);
-		SolveDiagonalConstraint2(NextLine, DiagonalLength);
-	}
-
-	void SolveHorizontalConstraint()
-	{
-		if (bFree)
-		{
-			int32 IterationCount = Positions.Num() - 1;
-			float DesiredDistance = HorizontalWidth / IterationCount;
-			for (int32 Idx = 0; Idx < IterationCount; ++Idx)
-				SolvePositionConstraint(Positions[Idx], true, Positions[Idx+1], true, DesiredDistance);
-		}
-	}
-
-	void SolveVerticalConstraint(FVerletClothHorizontalLine& NextLine, float DesiredDistance)
-	{
-		for (int32 Idx = 0; Idx < Positions.Num(); ++Idx)
-			SolvePositionConstraint(Positions[Idx], bFree, NextLine.Positions[Idx], NextLine.bFree, DesiredDistance);
-	}
-
-	// First Diagonal direction
-	void SolveDiagonalConstraint1(FVerletClothHorizontalLine& NextLine, float DesiredDistance)
-	{
-		for (int32 Idx = 0; Idx < Positions.Num() - 1; ++Idx)
-			SolvePositionConstraint(Positions[Idx], bFree, NextLine.Positions[Idx + 1], NextLine.bFree, DesiredDistance);
-	}
-
-	// Second diagonal direction
-	void SolveDiagonalConstraint2(FVerletClothHorizontalLine& NextLine, float DesiredDistance)
-	{		
-		for (int32 Idx = 0; Idx < Positions.Num() - 1; ++Idx)
-			SolvePositionConstraint(Positions[Idx + 1], bFree, NextLine.Positions[Idx], NextLine.bFree, DesiredDistance);
-	}
-
-	void SolvePositionConstraint(FVector& PositionA, bool bFreeA, FVector& PositionB, bool bFreeB, float DesiredDistance)
-	{
-		// Find current vector between lines
-		FVector Delta = PositionB - PositionA;
-		// 
-		float CurrentDistance = Delta.Size();
-		float ErrorFactor = (CurrentDistance - DesiredDistance) / CurrentDistance;
-		if (ErrorFactor <= 0.0f)
-			return;
-
-		// Only move free lines to satisfy constraints
-		if (bFreeA && bFreeB)
-		{
-			PositionA += ErrorFactor * 0.5f * Delta;
-			PositionB -= ErrorFactor * 0.5f * Delta;
-		}
-		else if (bFreeA)
-		{
-			PositionA += ErrorFactor * Delta;
-		}
-		else if (bFreeB)
-		{
-			PositionB -= ErrorFactor * Delta;
-		}
-	}
-
-	/** If this point is free (simulating) or fixed to something */
-	bool bFree;
-	/** total width of horizontal side */
-	int32 HorizontalWidth;
-	/** */
-	float Damping;
-	/** Current acceleration of point */
-	TArray<FVector> Acceleration;
-	/** Current position of point */
-	TArray<FVector> Positions;
-	/** if bFree, Position of point on previous iteration. if not, relative Position of previous point */
-	TArray<FVector> SavedPositions;	
+/** Cheaper simulation settings, used once the cloth is small enough on screen */
+USTRUCT(BlueprintType)
+struct FVerletClothLODSettings
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** The level is used below this screen size, the bounds radius divided by the distance to the closest view */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth", meta = (ClampMin = "0.0"))
+	float ScreenSize;
+
+	/** Solver iterations at this level */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth", meta = (ClampMin = "1", ClampMax = "100"))
+	int32 SolverIterations;
+
+	/** Simulation substeps per second at this level */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth", meta = (ClampMin = "1.0", UIMax = "60.0"))
+	float SubstepRate;
+
+	/** Lines and sides are divided by this factor, the coarser grid is interpolated back onto the rendered mesh */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth", meta = (ClampMin = "1", UIMax = "8"))
+	int32 GridReduction;
+
+	FVerletClothLODSettings()
+	: ScreenSize(0.1f), SolverIterations(5), SubstepRate(30.0f), GridReduction(1)
+	{}
+};
+
+/** Everything the simulation reads from the game thread, gathered once per frame so that it can run on any thread */
+struct FVerletClothSimulationInput
+{
+	FVerletClothSimulationInput()
+	: DeltaTime(0.0f), TimeDilation(1.0f), WorldGravityZ(0.0f), Gravity(FVector::ZeroVector), Wind(FVector::ZeroVector)
+	, CollisionPlane(ECollisionPlane::NONE), SubstepRate(60.0f), MaxSubsteps(0), DeterministicSubsteps(0), bInterpolateSubsteps(false)
+	, bWorldSpace(true), SideAxis(FVector::ForwardVector), ClothWidth(0.0f), WindGustStrength(0.0f), WindGustFrequency(0.0f)
+	, bAllowSleeping(false), SleepVelocityThreshold(0.0f), SleepMaxCorrection(0.0f), SleepSubstepCount(0), bTearable(false), TearStretchRatio(1.0f)
+	{}
+
+	/** Component transform at the time of the gather */
+	FTransform ComponentToWorld;
+	/** Frame time to simulate */
+	float DeltaTime;
+	/** Effective time dilation of the world */
+	float TimeDilation;
+	/** World settings gravity, used unless bUseLocalGravity is set */
+	float WorldGravityZ;
+	/** Gravity in simulation space, world or local */
+	FVector Gravity;
+	/** Wind in simulation space */
+	FVector Wind;
+	/** Wind source set with SetWindField, replaces Wind */
+	TSharedPtr<FVerletClothWindField, ESPMode::ThreadSafe> WindField;
+	/** Collision plane setting */
+	ECollisionPlane CollisionPlane;
+	/** Collision shapes in simulation space */
+	TArray<FVerletClothCollider, TInlineAllocator<4>> Colliders;
+	/** Solver and stiffness settings, with the solver iterations of the current LOD */
+	FVerletClothSimulationSettings Settings;
+	/** Substeps per second of the current LOD */
+	float SubstepRate;
+	/** Most substeps simulated this frame, 0 for no limit */
+	int32 MaxSubsteps;
+	/** Substeps of every frame in deterministic mode, 0 otherwise */
+	int32 DeterministicSubsteps;
+	/** Render between the last two substeps, off in deterministic mode */
+	bool bInterpolateSubsteps;
+	/** Simulated in world space, see ProcessWorldSpace */
+	bool bWorldSpace;
+	/** Direction of the pinned lines in simulation space, and the width they span */
+	FVector SideAxis;
+	float ClothWidth;
+	/** Gusts of the built in wind */
+	float WindGustStrength;
+	float WindGustFrequency;
+	/** Sleep settings, sleeping is off in deterministic mode, while a LOD blend runs and in wind that changes over time */
+	bool bAllowSleeping;
+	float SleepVelocityThreshold;
+	float SleepMaxCorrection;
+	int32 SleepSubstepCount;
+	/** Tearing settings */
+	bool bTearable;
+	float TearStretchRatio;
 };
 
 /** Component that allows you to specify custom triangle mesh geometry */
@@ -211,12 +166,14 @@ public:
 
 	//~ Begin UActorComponent Interface.
 	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
 	virtual void SendRenderDynamicData_Concurrent() override;
 
 	virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
 	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
 	virtual int32 GetNumMaterials() const override { return 1; }
+	virtual SIZE_T GetResourceSize(EResourceSizeMode::Type Mode) override;
 
 	/** How wide the cloth geometry is */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth", meta = (ClampMin = "0.01", UIMin = "0.01", UIMax = "50.0"))
@@ -234,6 +191,64 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth", meta = (ClampMin = "1", ClampMax = "100"))
 	int32 SolverIterations;
 
+	/** The solver stops iterating once no constraint moves its particles further than this in a sweep, settled cloth then only runs a few. 0 always runs every iteration. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth", meta = (ClampMin = "0.0", UIMax = "1.0"))
+	float SolverTolerance;
+
+	/** Over-relaxation of the constraint corrections, above 1 converges in fewer iterations but too high makes the cloth jitter */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth", meta = (ClampMin = "1.0", ClampMax = "1.9"))
+	float SolverRelaxation;
+
+	/**
+	 * Keeps every free particle within its rest distance along the cloth of the closest pinned particle.
+	 * Long cloths then hang without stretching even with few solver iterations.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth")
+	bool bLongRangeTethers;
+
+	/** How far tethers let particles go, relative to their rest distance to the anchor */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth", meta = (ClampMin = "1.0", UIMax = "1.5", EditCondition = "bLongRangeTethers"))
+	float TetherScale;
+
+	/** Solve constraints in independent color batches spread over worker threads instead of one sequential sweep. Converges slightly differently. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth")
+	bool bParallelSolver;
+
+	/**
+	 * Solve constraints with XPBD. Stiffness comes from the compliances below instead of the solver iterations and substep rate,
+	 * so the cloth keeps its stiffness when a LOD or a catch-up lowers them, it is only less converged.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Stiffness")
+	bool bUseXPBD;
+
+	/** Inverse stiffness of the structural constraints with XPBD, 0 being rigid */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth|Stiffness", meta = (ClampMin = "0.0", UIMax = "0.001", EditCondition = "bUseXPBD"))
+	float StretchCompliance;
+
+	/** Inverse stiffness of the diagonal constraints of grids with XPBD, 0 being rigid */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth|Stiffness", meta = (ClampMin = "0.0", UIMax = "0.001", EditCondition = "bUseXPBD"))
+	float ShearCompliance;
+
+	/** Inverse stiffness of the bending constraints of meshes with XPBD, 0 being rigid */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth|Stiffness", meta = (ClampMin = "0.0", UIMax = "0.001", EditCondition = "bUseXPBD"))
+	float BendCompliance;
+
+	/** Most substeps simulated in one frame, time beyond it is dropped so a long frame does not make the next one longer. 0 for no limit. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth", meta = (ClampMin = "0", UIMax = "16"))
+	int32 MaxSubstepsPerFrame;
+
+	/** Render the cloth between its last two substeps according to the time left over, smooth motion when substeps and frames don't line up */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth")
+	bool bInterpolateSubsteps;
+
+	/** Bounds are grown by this much and only updated once the cloth leaves them, saves most transform updates of a cloth moving in place. 0 for exact bounds. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth", meta = (ClampMin = "0.0", UIMax = "100.0"))
+	float BoundsPadding;
+
+	/** Simulate on a worker thread from the start of the frame and render the result one frame later, so the game thread never waits for the cloth. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth")
+	bool bAsyncSimulation;
+
 	/** Number of sides the cloth geometry has. (Horizontal) */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth", meta = (ClampMin = "1", ClampMax = "16"))
 	int32 NumSides;
@@ -246,6 +261,13 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth", meta = (ClampMin = "1"))
 	int32 FixedLineCount;
 
+	/**
+	 * Mesh the cloth is built from instead of the grid settings, for ropes, flags or capes cut to shape.
+	 * Vertices painted with a red vertex color are pinned to the component. Cooked meshes need CPU access.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth")
+	UStaticMesh* ClothMesh;
+
 	/** Including actor's trasform with simulating. */
 	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category = "Verlet Cloth")
 	bool ProcessWorldSpace;
@@ -262,6 +284,22 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth")
 	FVector Wind;
 
+	/** Fraction of the wind speed gusts add or take away, they travel along with the wind */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth", meta = (ClampMin = "0.0", UIMax = "1.0"))
+	float WindGustStrength;
+
+	/** Gusts per second going past any point of the cloth */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth", meta = (ClampMin = "0.0", UIMax = "4.0"))
+	float WindGustFrequency;
+
+	/** How strongly the wind pushes the cloth along its normals */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth", meta = (ClampMin = "0.0", UIMax = "2.0"))
+	float WindDrag;
+
+	/** How strongly wind blowing at an angle pushes the cloth across its direction, like a sail */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth", meta = (ClampMin = "0.0", UIMax = "2.0"))
+	float WindLift;
+
 	/** Horizontal line axis in component space. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth")
 	ESideAxis SideAxis;
@@ -270,15 +308,348 @@ public:
 	UPROPERTY( EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth" )
 	ECollisionPlane CollisionPlane;	
 
-private:
+	/** Shapes the cloth collides with, on top of the collision plane */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth")
+	TArray<FVerletClothCollisionShape> CollisionShapes;
+
+	/** Keep the cloth from passing through itself where it folds. Costs a spatial hash rebuild and a neighbor search every substep. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth|Self Collision")
+	bool bSelfCollision;
+
+	/** Closest distance two particles of the cloth get to each other, particles closer than this on the grid are not tested */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth|Self Collision", meta = (ClampMin = "0.01", UIMax = "50.0", EditCondition = "bSelfCollision"))
+	float SelfCollisionThickness;
+
+	/**
+	 * Structural constraints break once stretched too far and the cloth splits there, for sails and banners torn apart.
+	 * Torn grids are simulated at full resolution. Applies when the component is registered.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Tearing")
+	bool bTearable;
+
+	/** Length over rest length past which a constraint breaks */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Verlet Cloth|Tearing", meta = (ClampMin = "1.0", UIMax = "5.0", EditCondition = "bTearable"))
+	float TearStretchRatio;
+
+	/** Most particles tearing adds, the rendered mesh is allocated for as many new vertices up front */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Tearing", meta = (ClampMin = "0", UIMax = "1024", EditCondition = "bTearable"))
+	int32 MaxTornParticles;
+
+	/** Simulation LOD levels, from the largest screen size to the smallest. The component's own settings are used above the first one. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|LOD")
+	TArray<FVerletClothLODSettings> LODs;
+
+	/** Screen size has to grow this much past a threshold before going back to a finer level, avoids flickering between two levels */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|LOD", meta = (ClampMin = "0.0", UIMax = "1.0"))
+	float LODHysteresis;
+
+	/** Seconds the rendered mesh takes to blend from the previous level's shape when the simulated grid changes */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|LOD", meta = (ClampMin = "0.0", UIMax = "1.0"))
+	float LODTransitionTime;
+
+	/** Stop simulating once the cloth comes to rest, until its transform, gravity, wind or collision change. Never sleeps in gusty wind or a wind field. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Sleep")
+	bool bAllowSleeping;
+
+	/** Particles slower than this, in units per second, are at rest */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Sleep", meta = (ClampMin = "0.0", EditCondition = "bAllowSleeping"))
+	float SleepVelocityThreshold;
+
+	/** Largest constraint correction of the last solver sweep the cloth can fall asleep with, so a stretched cloth settles first */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Sleep", meta = (ClampMin = "0.0", EditCondition = "bAllowSleeping"))
+	float SleepMaxCorrection;
+
+	/** Substeps every particle has to stay at rest before the cloth falls asleep */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Sleep", meta = (ClampMin = "1", EditCondition = "bAllowSleeping"))
+	int32 SleepSubstepCount;
+
+	/** Slow down or pause the simulation while the cloth is not rendered, then catch up on the skipped time once it is */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Throttling")
+	bool bThrottleWhenNotRendered;
+
+	/** Seconds between two simulations while the cloth is not rendered, 0 pauses it */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Throttling", meta = (ClampMin = "0.0", EditCondition = "bThrottleWhenNotRendered"))
+	float NotRenderedTickInterval;
+
+	/** Longest skipped time simulated by one catch-up, anything beyond is dropped */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Throttling", meta = (ClampMin = "0.0", EditCondition = "bThrottleWhenNotRendered"))
+	float MaxCatchUpTime;
+
+	/** Solver iterations of a catch-up */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Throttling", meta = (ClampMin = "1", ClampMax = "100", EditCondition = "bThrottleWhenNotRendered"))
+	int32 CatchUpSolverIterations;
+
+	/** Substeps per second of a catch-up */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Throttling", meta = (ClampMin = "1.0", UIMax = "60.0", EditCondition = "bThrottleWhenNotRendered"))
+	float CatchUpSubstepRate;
+
+	/**
+	 * Every tick runs exactly DeterministicSubsteps substeps at the LOD's substep rate, whatever the frame time and time dilation.
+	 * Sleeping, throttling and LOD switches are off, so the same snapshot and input always give the same result.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Replay")
+	bool bDeterministic;
+
+	/** Substeps of every tick in deterministic mode */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Replay", meta = (ClampMin = "1", UIMax = "8", EditCondition = "bDeterministic"))
+	int32 DeterministicSubsteps;
+
+	/**
+	 * Seconds simulated when the component is registered without a rest pose, so the cloth is not seen dropping into place.
+	 * Runs with PreRollSubstepRate and PreRollSolverIterations, 0 starts from the straight sheet. Not used in deterministic mode.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Rest Pose", meta = (ClampMin = "0.0", UIMax = "5.0"))
+	float PreRollTime;
+
+	/** Substeps per second of the pre-roll */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Rest Pose", meta = (ClampMin = "1.0", UIMax = "60.0"))
+	float PreRollSubstepRate;
+
+	/** Solver iterations of the pre-roll */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Verlet Cloth|Rest Pose", meta = (ClampMin = "1", ClampMax = "100"))
+	int32 PreRollSolverIterations;
+
+	/** Resumes the simulation of a sleeping cloth, for changes the component cannot see such as moving collision */
+	UFUNCTION(BlueprintCallable, Category = "Verlet Cloth")
+	void WakeUp();
+
+	/** Returns true while the cloth is at rest and not simulated */
+	UFUNCTION(BlueprintCallable, Category = "Verlet Cloth")
+	bool IsSleeping() const { return bSleeping; }
+
+	/**
+	 * Blows wind from a custom source instead of Wind and the gust settings, NULL goes back to them.
+	 * The field is sampled by the simulation and must not change afterwards, set a new one instead.
+	 */
+	void SetWindField(TSharedPtr<FVerletClothWindField, ESPMode::ThreadSafe> InWindField);
+
+	/** Largest and RMS constraint correction of the last solver sweep, and how many sweeps the last substep ran */
+	UFUNCTION(BlueprintCallable, Category = "Verlet Cloth")
+	void GetSolverResidual(float& MaxCorrection, float& RMSCorrection, int32& IterationsRun) const;
+
+	/** Appends a snapshot of the particles and the simulation settings to Data, see FVerletClothSnapshot. Waits for an async simulation to finish. */
+	UFUNCTION(BlueprintCallable, Category = "Verlet Cloth|Replay")
+	void CaptureSnapshot(TArray<uint8>& Data);
+
+	/**
+	 * Puts the cloth back in the state of the snapshot at Offset in Data and moves Offset past it.
+	 * Solver, stiffness, wind response, tether and self collision settings are set from it too, gravity and wind come from the world as usual.
+	 * Returns false if the snapshot cannot be read or its particles do not match the simulated grid or mesh.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Verlet Cloth|Replay")
+	bool RestoreSnapshot(const TArray<uint8>& Data, UPARAM(ref) int32& Offset);
+
+	/**
+	 * Bakes the current shape of the cloth into the component, it starts from there at rest when registered instead of as a straight sheet.
+	 * Let the cloth settle in the editor viewport first. The pose is dropped once the grid or mesh changes, capture it again after changing the cloth.
+	 * Returns false while a LOD level is simulated or once the cloth tore.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Verlet Cloth|Rest Pose", meta = (CallInEditor = "true"))
+	bool CaptureRestPose();
+
+	/** Starts from the straight sheet again on register */
+	UFUNCTION(BlueprintCallable, Category = "Verlet Cloth|Rest Pose", meta = (CallInEditor = "true"))
+	void ClearRestPose();
+
+	/** Returns true if a rest pose is baked */
+	UFUNCTION(BlueprintCallable, Category = "Verlet Cloth|Rest Pose")
+	bool HasRestPose() const { return RestPose.Num() > 0; }
+
+protected:
+
+	virtual void RegisterComponentTickFunctions(bool bRegister) override;
 
-	void ProcessCollision();
-	void SolveConstraints();
-	void UpdateAcceleration(const FVector& Gravity, const FVector& WindVec);
-	void VerletIntegrate(float InTime);
+private:
 
-	/** Array of cloth lines */
-	TArray<FVerletClothHorizontalLine>	HorizontalLines;
+	friend class FVerletClothSimulationManager;
+	friend class FVerletClothSceneProxy;
+
+	/** Returns true if the world's simulation manager simulates this component instead of its own tick */
+	bool ShouldUseSimulationManager() const;
+
+	/** Captures the game thread state needed by Simulate */
+	FVerletClothSimulationInput GatherSimulationInput(float DeltaTime, float TimeDilation, float WorldGravityZ) const;
+	/** Runs the substeps of a frame, only touches the particles so it is safe to call from a worker thread */
+	void Simulate(const FVerletClothSimulationInput& Input);
+	/** Pushes the simulation results to the render thread and updates bounds, on the game thread */
+	void FinishSimulation();
+	/** Wakes the cloth if its input changed since it fell asleep, returns false if it keeps sleeping */
+	bool ShouldSimulate(const FVerletClothSimulationInput& Input);
+	/** Skips frames while the cloth is not rendered and turns the next simulation into a catch-up, returns false if this frame is skipped */
+	bool ThrottleSimulation(FVerletClothSimulationInput& Input);
+
+	/** Runs Simulate and writes the positions to the back buffer, on a worker thread */
+	void SimulateAsync(const FVerletClothSimulationInput& Input);
+	/** Waits for the simulation running on a worker thread, if any, and makes its result the rendered one. Returns true if there was one. */
+	bool CompleteAsyncSimulation();
+	/** Position of a particle as rendered, the front buffer in async mode */
+	FVector GetRenderedPosition(int32 Idx) const;
+	/** Position of a particle between its last two substeps */
+	FVector GetInterpolatedPosition(int32 Idx) const;
+	/** Bounds of the rendered particles in simulation space, the front buffer's in async mode */
+	const FBox& GetRenderedBounds() const;
+	/** Snapshot of the rendered vertices for the scene proxy */
+	FVerletClothDynamicData* CreateDynamicData() const;
+	/** Fills the tangents of a snapshot from its positions, so the render thread only copies them */
+	void BuildRenderedTangents(FVerletClothDynamicData& Data) const;
+	/** Fills the component space position of every rendered vertex, interpolating the simulated grid when it is coarser */
+	void GetRenderedVertices(FVector* OutPositions) const;
+	/** Vertices of the rendered mesh, the full resolution grid or the cloth mesh */
+	int32 GetNumRenderedVertices() const;
+	/** Restarts the async buffers from the current particles */
+	void ResetAsyncPositions();
+
+	/**
+	 * Picks the LOD level from the screen size and switches the simulated grid if needed, rebuilds the grid topology once the cloth size changed.
+	 * On the game thread with no simulation running.
+	 */
+	void UpdateLOD(float DeltaTime);
+	/** Size of the simulated grid at a LOD level */
+	void GetSimulationGridSize(int32 LODIdx, int32& OutNumLines, int32& OutNumPoints) const;
+	/** Moves the particles to a grid of another resolution, keeping their shape and velocity */
+	void ResampleParticles(int32 NumLines, int32 NumPoints);
+
+	/** Builds the grid topology of the simulated grid, unless the cloth comes from a mesh, and the batches of the parallel solver */
+	void BuildTopology();
+	/** Builds the batches of the parallel solver and the tethers from the topology */
+	void BuildSolverBatches();
+	void GatherColliders(FVerletClothSimulationInput& Input) const;
+	/** Finds the structural constraints stretched past StretchRatio, on the simulating thread */
+	void FindTears(float StretchRatio);
+	/** Splits the cloth at the constraints FindTears found, on the game thread with no simulation running */
+	void ApplyTears();
+	/** Solver and stiffness settings of the component, with its own solver iterations */
+	FVerletClothSimulationSettings GetSimulationSettings() const;
+	/** Settings recorded in snapshots, from the component and the current gravity and wind */
+	void GetSnapshotParams(FVerletClothSnapshotParams& OutParams) const;
+	/** Moves the free particles to the baked rest pose, returns false if there is none or it does not match the particles */
+	bool ApplyRestPose();
+	/** Hash of the full resolution topology and the settings shaping it, a rest pose only applies to the cloth it was captured from */
+	uint32 GetRestPoseTopologyHash() const;
+	/** Simulates PreRollTime with the pre-roll settings, on register */
+	void PreRoll();
+	/** Memory held by the particles, topology, solver batches and scratch buffers of the simulation */
+	uint32 GetSimulationAllocatedSize() const;
+	/** Reports the change of GetSimulationAllocatedSize since the last call to the memory stats, on the game thread */
+	void UpdateSimulationMemoryStat();
+
+	/** Particles of every cloth line */
+	FVerletClothParticles Particles;
+
+	/** Particles and constraints of the simulated grid or mesh */
+	FVerletClothTopology Topology;
+
+	/** Topology constraints split in independent batches, used by the parallel solver */
+	TArray<FVerletClothConstraintBatch> ConstraintBatches;
+	/** Constraint type of each batch */
+	TArray<uint8> ConstraintBatchTypes;
+
+	/** From each pinned anchor to the free particles it holds, empty without bLongRangeTethers */
+	FVerletClothConstraintBatch Tethers;
+
+	/** See SetWindField */
+	TSharedPtr<FVerletClothWindField, ESPMode::ThreadSafe> WindField;
+
+	/** Time simulated so far, substep by substep */
+	float SimulationTime;
+
+	/** Runs the substeps on the particles and constraints above, created on register */
+	TSharedPtr<FVerletClothSolver> Solver;
+
+	/** Where the pinned particles of a mesh are held during a frame, in simulation space */
+	TArray<FVector> PinnedPositions;
+
+	/** World space positions of the particles a wind field is sampled at when simulating in component space */
+	TArray<float> WindPositions;
+
+	/** Residual of the last solver sweep, see GetSolverResidual */
+	float SolverMaxCorrection;
+	float SolverRMSCorrection;
+	int32 SolverIterationsRun;
+
+	/** Residual as the simulation left it, written on the simulating thread and published by FinishSimulation */
+	float SimulatedMaxCorrection;
+	float SimulatedRMSCorrection;
+	int32 SimulatedIterationsRun;
+
+	/** Cloth size the grid rest lengths were computed with */
+	float BatchedClothLength;
+	float BatchedClothWidth;
 
 	FVector OldComponentLocation;
+
+	/** Saved position of the last line when pinned, pinned lines in between get a linear fraction of it */
+	FVector PinnedLineOffset;
+
+	/** Pinned lines of the simulated grid, FixedLineCount at full resolution */
+	int32 SimulatedFixedLineCount;
+
+	/** Current LOD level, 0 being the component's own settings */
+	int32 CurrentLOD;
+
+	/** Resting and settled substeps in a row, reset by WakeUp once no simulation is running */
+	int32 RestSubstepCount;
+
+	/** At rest and not simulated, only touched on the game thread */
+	bool bSleeping;
+
+	/** Came to rest during the last simulation, written on the simulating thread and published to bSleeping by FinishSimulation */
+	bool bSimulatedSleeping;
+
+	/** Input of the last simulation before falling asleep, any change wakes the cloth. Only read once asleep. */
+	FVerletClothSimulationInput SleepInput;
+
+	/** Time skipped by throttling and not simulated yet */
+	float ThrottledTime;
+
+	/** Time left over after the last substep, carried to the next frame */
+	float AccumulatedTime;
+
+	/** Where the rendered cloth is between the last two substeps, 1 being the last one */
+	float InterpolationAlpha;
+
+	/** Rendered vertices when the simulated grid last changed, blended out over LODTransitionTime */
+	TArray<FVector> LODBlendPositions;
+	/** Progress of the blend, 1 once finished */
+	float LODBlendAlpha;
+
+	/** Component space bounds of LODBlendPositions */
+	FBox LODBlendBounds;
+
+	/** Registered with the world's simulation manager */
+	bool bSimulatedByManager;
+
+	/** Completion of the simulation running on a worker thread in async mode */
+	FGraphEventRef AsyncSimulationEvent;
+
+	/** Async mode positions, the worker thread writes one buffer while the other one is rendered */
+	TArray<FVector> AsyncPositions[2];
+
+	/** Bounds of each async buffer */
+	FBox AsyncBounds[2];
+
+	/** Bounds of the particles after the last simulation, in simulation space */
+	FBox SimulatedBounds;
+
+	/** Padded bounds in simulation space, see BoundsPadding */
+	FBox PaddedBounds;
+
+	/** Index of the rendered buffer in AsyncPositions */
+	int32 AsyncReadIdx;
+
+	/** Snapshots sent to the render thread, recycled between frames and shared with the scene proxy */
+	TSharedPtr<FVerletClothDynamicDataPool, ESPMode::ThreadSafe> DynamicDataPool;
+
+	/** Topology constraints found stretched by the last simulation */
+	TArray<int32> PendingTears;
+
+	/** Tears not sent to the scene proxy yet */
+	FVerletClothMeshPatch PendingMeshPatch;
+
+	/** Simulation memory currently counted in the memory stats */
+	uint32 ReportedSimulationMemory;
+
+	/** Baked rest pose, see CaptureRestPose and FVerletClothRestPose. Empty to start as a straight sheet. */
+	UPROPERTY()
+	TArray<uint8> RestPose;
 };
\ No newline at end of file
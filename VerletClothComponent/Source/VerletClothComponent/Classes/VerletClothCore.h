@@ -0,0 +1,481 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+/**
+ * Simulation data of the cloth, independent of the component and of the engine's object model.
+ * Only uses core math and containers, so the kernels working on it also build standalone, see VerletClothCore/CMakeLists.txt.
+ */
+
+class UStaticMesh;
+
+/** Collision shape placed in simulation space for a frame */
+struct FVerletClothCollider
+{
+	/** Capsule from Start to End, a sphere when both are the same, or a box */
+	bool bBox;
+	FVector Start;
+	FVector End;
+	float Radius;
+	FQuat Rotation;
+	FVector Extent;
+	/** Broadphase bounds */
+	FBox Bounds;
+
+	bool Equals(const FVerletClothCollider& Other) const
+	{
+		return bBox == Other.bBox && Start.Equals(Other.Start) && End.Equals(Other.End) && FMath::IsNearlyEqual(Radius, Other.Radius)
+			&& Rotation.Equals(Other.Rotation) && Extent.Equals(Other.Extent);
+	}
+};
+
+/**
+ * Flat structure-of-arrays storage for every particle of the cloth.
+ * Particles are laid out line by line, NumPointsPerLine in each line, and every stream is padded
+ * so that it starts on an aligned boundary. All streams live in a single allocation.
+ * Particles added by tearing follow the lines.
+ */
+struct FVerletClothParticles
+{
+	enum EStream
+	{
+		PositionX = 0,
+		PositionY,
+		PositionZ,
+		SavedPositionX,
+		SavedPositionY,
+		SavedPositionZ,
+		AccelerationX,
+		AccelerationY,
+		AccelerationZ,
+		/** 1 if the particle is free (simulating), 0 if it is pinned */
+		FreeMask,
+		NumStreams
+	};
+
+	/** Number of floats every stream is padded to */
+	static const int32 StreamAlignment = 8;
+
+	FVerletClothParticles()
+	: NumLines(0), NumPointsPerLine(0), NumParticles(0), StreamStride(0)
+	{}
+
+	void Init(int32 InNumLines, int32 InNumPointsPerLine)
+	{
+		NumLines = InNumLines;
+		NumPointsPerLine = InNumPointsPerLine;
+		NumParticles = NumLines * NumPointsPerLine;
+		// Keep at least one padding particle around, see GetNullIndex
+		StreamStride = Align(NumParticles + 1, StreamAlignment);
+
+		Buffer.Reset();
+		Buffer.AddZeroed(StreamStride * NumStreams);
+	}
+
+	/** Adds pinned particles at the origin after the last one, the streams only move when they outgrow their padding */
+	void AddParticles(int32 Count)
+	{
+		const int32 NewNumParticles = NumParticles + Count;
+		const int32 NewStreamStride = Align(NewNumParticles + 1, StreamAlignment);
+		if (NewStreamStride != StreamStride)
+		{
+			TArray<float, TAlignedHeapAllocator<StreamAlignment * sizeof(float)>> NewBuffer;
+			NewBuffer.AddZeroed(NewStreamStride * NumStreams);
+			for (int32 Stream = 0; Stream < NumStreams; ++Stream)
+				FMemory::Memcpy(NewBuffer.GetData() + (Stream * NewStreamStride), Buffer.GetData() + (Stream * StreamStride), NumParticles * sizeof(float));
+			Buffer = MoveTemp(NewBuffer);
+			StreamStride = NewStreamStride;
+		}
+		NumParticles = NewNumParticles;
+	}
+
+	int32 GetIndex(int32 LineIdx, int32 PointIdx) const
+	{
+		return (LineIdx * NumPointsPerLine) + PointIdx;
+	}
+
+	/** Index of a padding particle which is always pinned at the origin, used to pad constraint batches */
+	int32 GetNullIndex() const
+	{
+		return NumParticles;
+	}
+
+	uint32 GetAllocatedSize() const
+	{
+		return Buffer.GetAllocatedSize();
+	}
+
+	float* GetStream(EStream Stream)
+	{
+		return Buffer.GetData() + (Stream * StreamStride);
+	}
+
+	const float* GetStream(EStream Stream) const
+	{
+		return Buffer.GetData() + (Stream * StreamStride);
+	}
+
+	FVector GetPosition(int32 Idx) const
+	{
+		return GetVector(PositionX, Idx);
+	}
+
+	void SetPosition(int32 Idx, const FVector& Value)
+	{
+		SetVector(PositionX, Idx, Value);
+	}
+
+	FVector GetSavedPosition(int32 Idx) const
+	{
+		return GetVector(SavedPositionX, Idx);
+	}
+
+	void SetSavedPosition(int32 Idx, const FVector& Value)
+	{
+		SetVector(SavedPositionX, Idx, Value);
+	}
+
+	FVector GetAcceleration(int32 Idx) const
+	{
+		return GetVector(AccelerationX, Idx);
+	}
+
+	void SetAcceleration(int32 Idx, const FVector& Value)
+	{
+		SetVector(AccelerationX, Idx, Value);
+	}
+
+	bool IsFree(int32 Idx) const
+	{
+		return GetStream(FreeMask)[Idx] != 0.0f;
+	}
+
+	void SetFree(int32 Idx, bool bFree)
+	{
+		GetStream(FreeMask)[Idx] = bFree ? 1.0f : 0.0f;
+	}
+
+	/** Corrections are scaled by Relaxation, returns how far the particles were moved */
+	float SolvePositionConstraint(int32 IdxA, int32 IdxB, float DesiredDistance, float Relaxation)
+	{
+		float* PosX = GetStream(PositionX);
+		float* PosY = GetStream(PositionY);
+		float* PosZ = GetStream(PositionZ);
+		const float* Free = GetStream(FreeMask);
+
+		// Find current vector between points
+		const float DeltaX = PosX[IdxB] - PosX[IdxA];
+		const float DeltaY = PosY[IdxB] - PosY[IdxA];
+		const float DeltaZ = PosZ[IdxB] - PosZ[IdxA];
+		const float CurrentDistance = FMath::Sqrt(DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ);
+		if (CurrentDistance <= SMALL_NUMBER)
+			return 0.0f;
+
+		const float ErrorFactor = (CurrentDistance - DesiredDistance) / CurrentDistance * Relaxation;
+		if (ErrorFactor <= 0.0f)
+			return 0.0f;
+
+		// Only move free points to satisfy constraints
+		const float FreeSum = Free[IdxA] + Free[IdxB];
+		if (FreeSum == 0.0f)
+			return 0.0f;
+
+		const float FactorA = ErrorFactor * Free[IdxA] / FreeSum;
+		const float FactorB = ErrorFactor * Free[IdxB] / FreeSum;
+		PosX[IdxA] += FactorA * DeltaX;
+		PosY[IdxA] += FactorA * DeltaY;
+		PosZ[IdxA] += FactorA * DeltaZ;
+		PosX[IdxB] -= FactorB * DeltaX;
+		PosY[IdxB] -= FactorB * DeltaY;
+		PosZ[IdxB] -= FactorB * DeltaZ;
+		return ErrorFactor * CurrentDistance;
+	}
+
+	/**
+	 * XPBD version of SolvePositionConstraint, Alpha is the compliance divided by the squared substep time.
+	 * Lambda is the multiplier accumulated over the substep, it only ever pulls the particles together.
+	 */
+	float SolveCompliantConstraint(int32 IdxA, int32 IdxB, float DesiredDistance, float Alpha, float Relaxation, float& Lambda)
+	{
+		float* PosX = GetStream(PositionX);
+		float* PosY = GetStream(PositionY);
+		float* PosZ = GetStream(PositionZ);
+		const float* Free = GetStream(FreeMask);
+
+		const float DeltaX = PosX[IdxB] - PosX[IdxA];
+		const float DeltaY = PosY[IdxB] - PosY[IdxA];
+		const float DeltaZ = PosZ[IdxB] - PosZ[IdxA];
+		const float CurrentDistance = FMath::Sqrt(DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ);
+		const float WeightSum = Free[IdxA] + Free[IdxB] + Alpha;
+		if (CurrentDistance <= SMALL_NUMBER || WeightSum <= SMALL_NUMBER)
+			return 0.0f;
+
+		const float NewLambda = FMath::Min(Lambda - (CurrentDistance - DesiredDistance + Alpha * Lambda) / WeightSum * Relaxation, 0.0f);
+		const float Factor = (Lambda - NewLambda) / CurrentDistance;
+		Lambda = NewLambda;
+
+		const float FactorA = Factor * Free[IdxA];
+		const float FactorB = Factor * Free[IdxB];
+		PosX[IdxA] += FactorA * DeltaX;
+		PosY[IdxA] += FactorA * DeltaY;
+		PosZ[IdxA] += FactorA * DeltaZ;
+		PosX[IdxB] -= FactorB * DeltaX;
+		PosY[IdxB] -= FactorB * DeltaY;
+		PosZ[IdxB] -= FactorB * DeltaZ;
+
+		// The multiplier can also relax back toward zero, which moves the particles apart
+		return FMath::Abs(FactorA + FactorB) * CurrentDistance;
+	}
+
+	/** Number of horizontal lines */
+	int32 NumLines;
+	/** Number of points in each horizontal line */
+	int32 NumPointsPerLine;
+	/** Total number of particles */
+	int32 NumParticles;
+	/** Number of floats between the start of two streams */
+	int32 StreamStride;
+	/**
+	 * Single aligned allocation holding every stream.
+	 * Saved position holds the position on previous iteration if the particle is free, or its relative position if not.
+	 */
+	TArray<float, TAlignedHeapAllocator<StreamAlignment * sizeof(float)>> Buffer;
+
+private:
+
+	FVector GetVector(EStream StreamX, int32 Idx) const
+	{
+		const float* Data = Buffer.GetData() + (StreamX * StreamStride) + Idx;
+		return FVector(Data[0], Data[StreamStride], Data[StreamStride * 2]);
+	}
+
+	void SetVector(EStream StreamX, int32 Idx, const FVector& Value)
+	{
+		float* Data = Buffer.GetData() + (StreamX * StreamStride) + Idx;
+		Data[0] = Value.X;
+		Data[StreamStride] = Value.Y;
+		Data[StreamStride * 2] = Value.Z;
+	}
+};
+
+/**
+ * Distance constraints in flat buffers.
+ * Solver batches never share a particle, so they can be solved in any order or in parallel,
+ * and they are padded with constraints on the null particle to a multiple of FVerletClothParticles::StreamAlignment.
+ */
+struct FVerletClothConstraintBatch
+{
+	void Add(int32 IdxA, int32 IdxB, float InRestLength)
+	{
+		IndexA.Add(IdxA);
+		IndexB.Add(IdxB);
+		RestLength.Add(InRestLength);
+		Lambda.Add(0.0f);
+	}
+
+	/** Starts a substep of the XPBD solver */
+	void ResetLambda()
+	{
+		FMemory::Memzero(Lambda.GetData(), Lambda.Num() * sizeof(float));
+	}
+
+	void Pad(int32 NullIdx)
+	{
+		while (Num() % FVerletClothParticles::StreamAlignment != 0)
+			Add(NullIdx, NullIdx, 0.0f);
+	}
+
+	int32 Num() const
+	{
+		return IndexA.Num();
+	}
+
+	uint32 GetAllocatedSize() const
+	{
+		return IndexA.GetAllocatedSize() + IndexB.GetAllocatedSize() + RestLength.GetAllocatedSize() + Lambda.GetAllocatedSize();
+	}
+
+	/** First particle of each constraint */
+	TArray<int32> IndexA;
+	/** Second particle of each constraint */
+	TArray<int32> IndexB;
+	/** Distance the constraint does not stretch beyond */
+	TArray<float> RestLength;
+	/** XPBD multiplier of each constraint over the current substep */
+	TArray<float> Lambda;
+};
+
+/** Changes tearing made to the rendered mesh, applied by the scene proxy instead of rebuilding the whole mesh */
+struct FVerletClothMeshPatch
+{
+	FVerletClothMeshPatch()
+	: FirstNewVertex(0)
+	{}
+
+	void Reset()
+	{
+		FirstNewVertex = 0;
+		SourceVertices.Reset();
+		Triangles.Reset();
+		TriangleIndices.Reset();
+	}
+
+	/** First vertex added, the others follow it */
+	int32 FirstNewVertex;
+	/** Vertex each added vertex copies its UV and color from */
+	TArray<int32> SourceVertices;
+	/** Triangles whose indices changed, and their three new indices */
+	TArray<int32> Triangles;
+	TArray<uint32> TriangleIndices;
+};
+
+/**
+ * Particles, distance constraints and triangles of a cloth, built from the grid settings or from a static mesh.
+ * Constraints are sorted by type, then by their first particle, so the sequential solver walks memory in order.
+ * Mesh vertices sharing a position are welded into one particle, particles are ordered by first use in the index buffer.
+ */
+struct FVerletClothTopology
+{
+	enum EConstraintType
+	{
+		/** Edges of the grid or the mesh */
+		Structural = 0,
+		/** Diagonals of the grid quads */
+		Shear,
+		/** Between the opposite corners of two triangles sharing an edge */
+		Bend,
+		NumConstraintTypes
+	};
+
+	FVerletClothTopology()
+	: bGrid(true), bTorn(false), NumParticles(0), MaxParticles(0), MaxRenderVertices(0)
+	{}
+
+	/** Empties the topology back to a grid yet to be built, nothing left refers to the particles of a previous cloth */
+	void Reset();
+
+	/**
+	 * Builds a grid of NumLines lines of NumPoints points, the first NumFixedLines being pinned.
+	 * With bRenderMesh the rendered vertices and triangles are built too, one vertex per particle.
+	 */
+	void BuildGrid(int32 NumLines, int32 NumPoints, int32 NumFixedLines, float Length, float Width, bool bRenderMesh);
+
+#if !VERLETCLOTH_STANDALONE
+	/**
+	 * Builds the particles of the first LOD of a static mesh, vertices with a red vertex color above one half are pinned.
+	 * Returns false if the mesh has no triangles or its data cannot be read, cooked meshes need CPU access.
+	 */
+	bool BuildFromMesh(const UStaticMesh* Mesh);
+#endif
+
+	/** Splits the constraints in batches which never share a particle, padded for the kernels, one type at a time */
+	void BuildBatches(TArray<FVerletClothConstraintBatch>& OutBatches, TArray<uint8>& OutBatchTypes, int32 NullIdx) const;
+
+	/**
+	 * Ties every free particle to its closest pinned particle along the cloth, no further than the path between them times Scale.
+	 * Tethers share their pinned anchors, they are padded for the kernels.
+	 */
+	void BuildTethers(FVerletClothConstraintBatch& OutTethers, float Scale, int32 NullIdx) const;
+
+	/** Lets tearing add this many particles, and as many rendered vertices */
+	void SetTearBudget(int32 NumTornParticles)
+	{
+		MaxParticles = NumParticles + NumTornParticles;
+		MaxRenderVertices = RenderParticles.Num() + NumTornParticles;
+	}
+
+	/**
+	 * Tears the cloth at a particle, the triangles in front of the plane through it move to a new particle.
+	 * Constraints follow the side of their other particle, rendered vertices used on both sides are duplicated.
+	 * Changes of the rendered mesh are added to OutPatch. Call Finish once done tearing.
+	 * Returns the new particle, or INDEX_NONE if the particle cannot be torn there or the budget is spent.
+	 */
+	int32 SplitParticle(int32 Idx, const FVector& Normal, const FVerletClothParticles& Particles, FVerletClothMeshPatch& OutPatch);
+
+	/** Drops pinned constraints, sorts them and counts the triangles of each particle */
+	void Finish();
+
+	/** Rendered from RenderParticles instead of the full resolution grid */
+	bool HasRenderMesh() const
+	{
+		return RenderParticles.Num() > 0;
+	}
+
+	uint32 GetAllocatedSize() const
+	{
+		return RestPositions.GetAllocatedSize() + Pinned.GetAllocatedSize() + PinnedParticles.GetAllocatedSize()
+			+ Constraints.GetAllocatedSize() + ConstraintTypes.GetAllocatedSize()
+			+ Triangles.GetAllocatedSize() + TriangleCorners[0].GetAllocatedSize() + TriangleCorners[1].GetAllocatedSize() + TriangleCorners[2].GetAllocatedSize()
+			+ InvTriangleCounts.GetAllocatedSize()
+			+ RenderParticles.GetAllocatedSize() + RenderUVs.GetAllocatedSize() + RenderColors.GetAllocatedSize() + RenderIndices.GetAllocatedSize();
+	}
+
+	/** Built from the grid settings, the particles are laid out line by line */
+	bool bGrid;
+
+	/** Particles were split by tearing, the grid settings do not describe the cloth anymore */
+	bool bTorn;
+
+	int32 NumParticles;
+
+	/** Limits of tearing, see SetTearBudget */
+	int32 MaxParticles;
+	int32 MaxRenderVertices;
+
+	/** Rest shape of the particles, the flat grid or the mesh in component space. Pinned mesh particles are held there. */
+	TArray<FVector> RestPositions;
+	TArray<bool> Pinned;
+	TArray<int32> PinnedParticles;
+
+	/** Constraints between two pinned particles are left out */
+	FVerletClothConstraintBatch Constraints;
+	TArray<uint8> ConstraintTypes;
+
+	/** Particle triangles, three indices each. They match the rendered triangles one to one when there is a render mesh. */
+	TArray<int32> Triangles;
+	/** Same triangles one corner at a time, for the kernels */
+	TArray<int32> TriangleCorners[3];
+	/** One over the number of triangles using each particle */
+	TArray<float> InvTriangleCounts;
+
+	/**
+	 * Mesh vertices rendered for the cloth, with the particle each one follows.
+	 * Empty for grids that cannot tear, the proxy builds them at full resolution.
+	 */
+	TArray<int32> RenderParticles;
+	TArray<FVector2D> RenderUVs;
+	TArray<FColor> RenderColors;
+	TArray<uint32> RenderIndices;
+
+private:
+
+	void AddConstraint(int32 IdxA, int32 IdxB, EConstraintType Type);
+	void AddTriangle(int32 IdxA, int32 IdxB, int32 IdxC);
+};
+
+/** Solver, stiffness and wind response settings, copied from the component every frame so the simulation never reads it */
+struct FVerletClothSimulationSettings
+{
+	FVerletClothSimulationSettings()
+	: Damping(0.0f), SolverIterations(1), SolverTolerance(0.0f), SolverRelaxation(1.0f), bParallelSolver(false), ParallelBatchSize(256)
+	, bUseXPBD(false), WindDrag(0.0f), WindLift(0.0f), SelfCollisionThickness(0.0f)
+	{
+		for (int32 Type = 0; Type < FVerletClothTopology::NumConstraintTypes; ++Type)
+			Compliance[Type] = 0.0f;
+	}
+
+	float Damping;
+	int32 SolverIterations;
+	float SolverTolerance;
+	float SolverRelaxation;
+	/** Solve the constraint batches on worker threads, ParallelBatchSize constraints per task */
+	bool bParallelSolver;
+	int32 ParallelBatchSize;
+	bool bUseXPBD;
+	/** XPBD compliance of each constraint type */
+	float Compliance[FVerletClothTopology::NumConstraintTypes];
+	float WindDrag;
+	float WindLift;
+	/** 0 without self collision */
+	float SelfCollisionThickness;
+};
@@ -0,0 +1,106 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "VerletClothCore.h"
+
+/** Settings a snapshot was simulated with, the same state replayed with other ones goes elsewhere */
+struct FVerletClothSnapshotParams
+{
+	FVerletClothSnapshotParams()
+	: SubstepTime(0.0f), Gravity(FVector::ZeroVector), Wind(FVector::ZeroVector), TetherScale(0.0f)
+	{}
+
+	float SubstepTime;
+	/** Solver, stiffness, wind response and self collision settings. bParallelSolver and ParallelBatchSize are not saved. */
+	FVerletClothSimulationSettings Settings;
+	/** Gravity and wind in simulation space */
+	FVector Gravity;
+	FVector Wind;
+	/** 0 without tethers */
+	float TetherScale;
+};
+
+/**
+ * Particle state of a cloth between two substeps, with the settings it is simulated with.
+ * Saved in a compact little endian binary format, snapshots of a run can follow each other in one buffer.
+ * Accelerations are left out, every substep computes them again.
+ */
+struct FVerletClothSnapshot
+{
+	FVerletClothSnapshot()
+	: Time(0.0f), NumLines(0), NumPointsPerLine(0), NumParticles(0)
+	{}
+
+	/** Copies the state of the particles */
+	void Capture(const FVerletClothParticles& Particles);
+
+	/** Puts the particles back in the captured state, returns false and leaves them alone if their layout differs */
+	bool Restore(FVerletClothParticles& Particles) const;
+
+	/** Appends the snapshot to Data */
+	void Save(TArray<uint8>& Data) const;
+
+	/** Reads the snapshot at Offset and moves it past it, returns false if the data is not a snapshot of this version */
+	bool Load(const TArray<uint8>& Data, int32& Offset);
+
+	/** Largest distance between the positions of a particle in both snapshots, MAX_flt if their layouts differ */
+	float GetMaxDifference(const FVerletClothSnapshot& Other) const;
+
+	/** Simulated time when captured */
+	float Time;
+	FVerletClothSnapshotParams Params;
+
+	int32 NumLines;
+	int32 NumPointsPerLine;
+	int32 NumParticles;
+
+	/** X, Y then Z of every particle, NumParticles each */
+	TArray<float> Positions;
+	TArray<float> SavedPositions;
+	/** 1 for free particles */
+	TArray<uint8> Free;
+};
+
+/**
+ * Settled shape of a cloth baked in the editor, the cloth starts from it at rest instead of as a straight sheet.
+ * Positions are in component space and quantized to 16 bits per axis within their bounds, 6 bytes a particle.
+ */
+struct FVerletClothRestPose
+{
+	FVerletClothRestPose()
+	: NumLines(0), NumPointsPerLine(0), NumParticles(0), TopologyHash(0), BoundsMin(FVector::ZeroVector), BoundsMax(FVector::ZeroVector)
+	{}
+
+	/** Quantizes the component space positions of particles laid out in NumLines lines of NumPointsPerLine */
+	void Capture(const TArray<FVector>& InPositions, int32 InNumLines, int32 InNumPointsPerLine);
+
+	/** Returns true if the pose was captured from particles laid out like these, of a cloth whose topology hashes to InTopologyHash */
+	bool Matches(const FVerletClothParticles& Particles, uint32 InTopologyHash) const
+	{
+		return Particles.NumLines == NumLines && Particles.NumPointsPerLine == NumPointsPerLine && Particles.NumParticles == NumParticles && TopologyHash == InTopologyHash;
+	}
+
+	/** Component space position of a particle, within half a quantization step of the captured one */
+	FVector GetPosition(int32 Idx) const;
+
+	/** Appends the pose to Data */
+	void Save(TArray<uint8>& Data) const;
+
+	/** Reads the pose at Offset and moves it past it, returns false if the data is not a pose of this version */
+	bool Load(const TArray<uint8>& Data, int32& Offset);
+
+	int32 NumLines;
+	int32 NumPointsPerLine;
+	int32 NumParticles;
+
+	/** Hash of the rest lengths, pins and shape settings of the cloth captured, set by the owner */
+	uint32 TopologyHash;
+
+	/** Bounds the positions are quantized in */
+	FVector BoundsMin;
+	FVector BoundsMax;
+
+	/** X, Y then Z of every particle, NumParticles each, 0 at BoundsMin and MAX_uint16 at BoundsMax */
+	TArray<uint16> Positions;
+};
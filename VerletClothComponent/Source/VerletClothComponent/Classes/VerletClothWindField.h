@@ -0,0 +1,62 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+/**
+ * Source of the wind blowing on a cloth, sampled for every particle at once each substep.
+ * Positions and wind velocities are in world space. It is sampled from simulation threads,
+ * so it must not change while a cloth using it simulates, see UVerletClothComponent::SetWindField.
+ */
+class VERLETCLOTHCOMPONENT_API FVerletClothWindField
+{
+public:
+
+	virtual ~FVerletClothWindField() {}
+
+	/** Writes the wind velocity at Num positions given as separate streams, Time is the simulated time in seconds */
+	virtual void SampleWind(const float* PosX, const float* PosY, const float* PosZ, int32 Num, float Time, float* OutX, float* OutY, float* OutZ) const = 0;
+};
+
+/** Same wind everywhere, at any time */
+class VERLETCLOTHCOMPONENT_API FVerletClothConstantWind : public FVerletClothWindField
+{
+public:
+
+	explicit FVerletClothConstantWind(const FVector& InVelocity);
+
+	virtual void SampleWind(const float* PosX, const float* PosY, const float* PosZ, int32 Num, float Time, float* OutX, float* OutY, float* OutZ) const override;
+
+	FVector Velocity;
+};
+
+/** Wind along one direction, with gusts of stronger and weaker wind carried along by it */
+class VERLETCLOTHCOMPONENT_API FVerletClothGustWind : public FVerletClothWindField
+{
+public:
+
+	FVerletClothGustWind(const FVector& InVelocity, float InGustStrength, float InGustFrequency);
+
+	virtual void SampleWind(const float* PosX, const float* PosY, const float* PosZ, int32 Num, float Time, float* OutX, float* OutY, float* OutZ) const override;
+
+	/** Average wind */
+	FVector Velocity;
+	/** Fraction of the average wind speed the gusts add or take away */
+	float GustStrength;
+	/** Gusts per second going past any point */
+	float GustFrequency;
+};
+
+/** Wind velocities on a regular grid over a box, interpolated in between and clamped outside of it */
+class VERLETCLOTHCOMPONENT_API FVerletClothWindVolume : public FVerletClothWindField
+{
+public:
+
+	/** Velocities are laid out X first then Y then Z, with at least two of them along each axis */
+	FVerletClothWindVolume(const FBox& InBounds, const FIntVector& InResolution, const TArray<FVector>& InVelocities);
+
+	virtual void SampleWind(const float* PosX, const float* PosY, const float* PosZ, int32 Num, float Time, float* OutX, float* OutY, float* OutZ) const override;
+
+	FBox Bounds;
+	FIntVector Resolution;
+	TArray<FVector> Velocities;
+};
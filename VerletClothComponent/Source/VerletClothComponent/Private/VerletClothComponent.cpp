@@ -1,40 +1,195 @@
 // Copyright 2016 Moai Games, Inc. All Rights Reserved.
 
 #include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothKernels.h"
+#include "VerletClothSimulationManager.h"
+#include "VerletClothSnapshot.h"
+#include "VerletClothSolver.h"
+#include "VerletClothStats.h"
+#include "VerletClothWindField.h"
 #include "DynamicMeshBuilder.h"
 #include "EngineGlobals.h"
 #include "LocalVertexFactory.h"
 #include "Engine/Engine.h"
 
-DECLARE_CYCLE_STAT(TEXT("Update Verlet Cloth Time"), STAT_UpdateVerletClothTime, STATGROUP_Game)
+static TAutoConsoleVariable<int32> CVarVerletClothParallelBatchSize(
+	TEXT("verletcloth.ParallelSolver.BatchSize"),
+	256,
+	TEXT("Number of constraints solved by a single task of the parallel solver."),
+	ECVF_Default);
 
-/** Vertex Buffer */
+/** World space wind field sampled at the particles of a cloth simulated in component space, the wind comes back in component space */
+class FVerletClothComponentSpaceWind : public FVerletClothWindField
+{
+public:
+
+	FVerletClothComponentSpaceWind(const FVerletClothWindField& InWorldWind, const FTransform& InComponentToWorld, TArray<float>& InWorldPositions)
+		: WorldWind(InWorldWind)
+		, ComponentToWorld(InComponentToWorld)
+		, WorldPositions(InWorldPositions)
+	{}
+
+	virtual void SampleWind(const float* PosX, const float* PosY, const float* PosZ, int32 Num, float Time, float* OutX, float* OutY, float* OutZ) const override
+	{
+		WorldPositions.SetNumUninitialized(Num * 3);
+		float* WorldX = WorldPositions.GetData();
+		float* WorldY = WorldX + Num;
+		float* WorldZ = WorldY + Num;
+		for (int32 Idx = 0; Idx < Num; ++Idx)
+		{
+			const FVector Position = ComponentToWorld.TransformPosition(FVector(PosX[Idx], PosY[Idx], PosZ[Idx]));
+			WorldX[Idx] = Position.X;
+			WorldY[Idx] = Position.Y;
+			WorldZ[Idx] = Position.Z;
+		}
+
+		WorldWind.SampleWind(WorldX, WorldY, WorldZ, Num, Time, OutX, OutY, OutZ);
+
+		for (int32 Idx = 0; Idx < Num; ++Idx)
+		{
+			const FVector LocalWind = ComponentToWorld.InverseTransformVector(FVector(OutX[Idx], OutY[Idx], OutZ[Idx]));
+			OutX[Idx] = LocalWind.X;
+			OutY[Idx] = LocalWind.Y;
+			OutZ[Idx] = LocalWind.Z;
+		}
+	}
+
+private:
+
+	const FVerletClothWindField& WorldWind;
+	const FTransform& ComponentToWorld;
+	/** Scratch space owned by the component, reused every substep */
+	TArray<float>& WorldPositions;
+};
+
+/** Vertex Buffer, dynamic buffers are rewritten every frame while static ones are uploaded once from InitialData */
 class FVerletClothVertexBuffer : public FVertexBuffer
 {
 public:
+
+	FVerletClothVertexBuffer()
+		: NumVerts(0)
+		, Stride(0)
+		, bDynamic(true)
+	{}
+
 	virtual void InitRHI() override
 	{
 		FRHIResourceCreateInfo CreateInfo;
-		VertexBufferRHI = RHICreateVertexBuffer(NumVerts * sizeof(FDynamicMeshVertex), BUF_Dynamic, CreateInfo);
+		const uint32 Size = NumVerts * Stride;
+		if (bDynamic)
+		{
+			VertexBufferRHI = RHICreateVertexBuffer(Size, BUF_Dynamic, CreateInfo);
+		}
+		else
+		{
+			check(InitialData.Num() == Size);
+			void* Data = NULL;
+			VertexBufferRHI = RHICreateAndLockVertexBuffer(Size, BUF_Static, CreateInfo, Data);
+			FMemory::Memcpy(Data, InitialData.GetData(), Size);
+			RHIUnlockVertexBuffer(VertexBufferRHI);
+		}
+	}
+
+	/** Uploads a range of InitialData again, for vertices a static buffer gained after it was created */
+	void UpdateVertices(int32 FirstVertex, int32 Count)
+	{
+		check(!bDynamic && (FirstVertex + Count) * Stride <= (uint32)InitialData.Num());
+		void* Data = RHILockVertexBuffer(VertexBufferRHI, FirstVertex * Stride, Count * Stride, RLM_WriteOnly);
+		FMemory::Memcpy(Data, InitialData.GetData() + FirstVertex * Stride, Count * Stride);
+		RHIUnlockVertexBuffer(VertexBufferRHI);
 	}
 
 	int32 NumVerts;
+	uint32 Stride;
+	bool bDynamic;
+
+	/** Content of a static buffer, kept so the resource can be reinitialized */
+	TArray<uint8> InitialData;
 };
 
-/** Index Buffer */
+/** Index Buffer, uploaded once and only patched where the cloth tears */
 class FVerletClothIndexBuffer : public FIndexBuffer
 {
 public:
+
+	FVerletClothIndexBuffer()
+		: NumVerts(0)
+	{}
+
 	virtual void InitRHI() override
 	{
+		const uint32 Stride = GetStride();
 		FRHIResourceCreateInfo CreateInfo;
-		IndexBufferRHI = RHICreateIndexBuffer(sizeof(int32), NumIndices * sizeof(int32), BUF_Dynamic, CreateInfo);
+		void* Data = NULL;
+		IndexBufferRHI = RHICreateAndLockIndexBuffer(Stride, Indices.Num() * Stride, BUF_Static, CreateInfo, Data);
+		CopyIndices(Data, 0, Indices.Num());
+		RHIUnlockIndexBuffer(IndexBufferRHI);
+	}
+
+	/** Uploads a triangle of Indices again */
+	void UpdateTriangle(int32 TriangleIdx)
+	{
+		const uint32 Stride = GetStride();
+		void* Data = RHILockIndexBuffer(IndexBufferRHI, TriangleIdx * 3 * Stride, 3 * Stride, RLM_WriteOnly);
+		CopyIndices(Data, TriangleIdx * 3, 3);
+		RHIUnlockIndexBuffer(IndexBufferRHI);
+	}
+
+	/** 16 bit indices whenever every vertex can be addressed with them */
+	uint32 GetStride() const
+	{
+		return NumVerts <= MAX_uint16 + 1 ? sizeof(uint16) : sizeof(uint32);
+	}
+
+	/** Vertices the buffer can address */
+	int32 NumVerts;
+
+	/** Triangle list, kept so the resource can be reinitialized */
+	TArray<uint32> Indices;
+
+private:
+
+	void CopyIndices(void* Data, int32 First, int32 Count) const
+	{
+		if (GetStride() == sizeof(uint16))
+		{
+			uint16* Data16 = (uint16*)Data;
+			for (int32 Idx = 0; Idx < Count; ++Idx)
+				Data16[Idx] = (uint16)Indices[First + Idx];
+		}
+		else
+		{
+			FMemory::Memcpy(Data, &Indices[First], Count * sizeof(uint32));
+		}
 	}
+};
 
-	int32 NumIndices;
+/** Per vertex data of the static stream */
+struct FVerletClothStaticVertex
+{
+	FVector2D TextureCoordinate;
+	FColor Color;
+};
+
+/** Per vertex data of the dynamic tangent stream */
+struct FVerletClothTangentVertex
+{
+	FPackedNormal TangentX;
+	FPackedNormal TangentZ;
+
+	void SetTangents(const FVector& InTangentX, const FVector& InTangentY, const FVector& InTangentZ)
+	{
+		TangentX = InTangentX;
+		TangentZ = InTangentZ;
+		// store determinant of basis in w component of normal vector
+		TangentZ.Vector.W = GetBasisDeterminantSign(InTangentX, InTangentY, InTangentZ) < 0.0f ? 0 : 255;
+	}
 };
 
-/** Vertex Factory */
+static_assert(sizeof(FVerletClothTangentVertex) == 2 * sizeof(uint32), "ComputeGridTangents writes the tangent vertices as pairs of packed normals");
+
+/** Vertex Factory reading positions and tangents from their own dynamic streams, UVs and colors from a static one */
 class FVerletClothVertexFactory : public FLocalVertexFactory
 {
 public:
@@ -44,18 +199,20 @@ public:
 
 
 	/** Initialization */
-	void Init(const FVerletClothVertexBuffer* VertexBuffer)
+	void Init(const FVerletClothVertexBuffer* PositionBuffer, const FVerletClothVertexBuffer* TangentBuffer, const FVerletClothVertexBuffer* StaticBuffer)
 	{
+		// Initialize the vertex factory's stream components.
+		DataType NewData;
+		NewData.PositionComponent = FVertexStreamComponent(PositionBuffer, 0, sizeof(FVector), VET_Float3);
+		NewData.TextureCoordinates.Add(
+			FVertexStreamComponent(StaticBuffer, STRUCT_OFFSET(FVerletClothStaticVertex, TextureCoordinate), sizeof(FVerletClothStaticVertex), VET_Float2)
+		);
+		NewData.ColorComponent = FVertexStreamComponent(StaticBuffer, STRUCT_OFFSET(FVerletClothStaticVertex, Color), sizeof(FVerletClothStaticVertex), VET_Color);
+		NewData.TangentBasisComponents[0] = FVertexStreamComponent(TangentBuffer, STRUCT_OFFSET(FVerletClothTangentVertex, TangentX), sizeof(FVerletClothTangentVertex), VET_PackedNormal);
+		NewData.TangentBasisComponents[1] = FVertexStreamComponent(TangentBuffer, STRUCT_OFFSET(FVerletClothTangentVertex, TangentZ), sizeof(FVerletClothTangentVertex), VET_PackedNormal);
+
 		if (IsInRenderingThread())
 		{
-			// Initialize the vertex factory's stream components.
-			DataType NewData;
-			NewData.PositionComponent = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, Position, VET_Float3);
-			NewData.TextureCoordinates.Add(
-				FVertexStreamComponent(VertexBuffer, STRUCT_OFFSET(FDynamicMeshVertex, TextureCoordinate), sizeof(FDynamicMeshVertex), VET_Float2)
-			);
-			NewData.TangentBasisComponents[0] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, TangentX, VET_PackedNormal);
-			NewData.TangentBasisComponents[1] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, TangentZ, VET_PackedNormal);
 			SetData(NewData);
 		}
 		else
@@ -63,33 +220,71 @@ public:
 			ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
 				InitClothVertexFactory,
 				FVerletClothVertexFactory*, VertexFactory, this,
-				const FVerletClothVertexBuffer*, VertexBuffer, VertexBuffer,
+				FLocalVertexFactory::DataType, NewData, NewData,
 				{
-					// Initialize the vertex factory's stream components.
-					DataType NewData;
-			NewData.PositionComponent = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer,FDynamicMeshVertex,Position,VET_Float3);
-			NewData.TextureCoordinates.Add(
-				FVertexStreamComponent(VertexBuffer,STRUCT_OFFSET(FDynamicMeshVertex,TextureCoordinate),sizeof(FDynamicMeshVertex),VET_Float2)
-			);
-			NewData.TangentBasisComponents[0] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer,FDynamicMeshVertex,TangentX,VET_PackedNormal);
-			NewData.TangentBasisComponents[1] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer,FDynamicMeshVertex,TangentZ,VET_PackedNormal);
-			VertexFactory->SetData(NewData);
+					VertexFactory->SetData(NewData);
 				});
 		}
 	}
 };
 
-/** Dynamic data sent to render thread */
-struct FVerletClothDynamicHorizontalLine
+/** Dynamic data sent to render thread, component space positions and their tangents, ready to be copied to the buffers */
+struct FVerletClothDynamicData
 {
-	/** Array of points */
-	TArray<FVector> Points;
+	int32 NumLines;
+	int32 NumPointsPerLine;
+
+	/** Array of points, NumPointsPerLine for each line */
+	TArray<FVector> Positions;
+
+	/** Tangent frame of every point */
+	TArray<FVerletClothTangentVertex> Tangents;
+
+	/** Tears since the previous snapshot, applied before the positions */
+	FVerletClothMeshPatch MeshPatch;
+
+	/** Scratch space of the mesh tangents, recycled with the snapshot */
+	TArray<FVector> ParticleNormals;
+	TArray<FVector> VertexTangents;
+
+	const FVector& GetPosition(int32 LineIdx, int32 PointIdx) const
+	{
+		return Positions[LineIdx * NumPointsPerLine + PointIdx];
+	}
 };
 
-struct FVerletClothDynamicData
+/**
+ * Recycles dynamic data between frames, so sending a snapshot does not allocate once the pool is warm.
+ * Shared by the component and its scene proxy so either one can go away first.
+ */
+class FVerletClothDynamicDataPool
 {
-	/** Array of lines */
-	TArray<FVerletClothDynamicHorizontalLine> HorizontalLines;
+public:
+
+	~FVerletClothDynamicDataPool()
+	{
+		while (FVerletClothDynamicData* Data = FreeList.Pop())
+		{
+			delete Data;
+		}
+	}
+
+	/** Returns a free snapshot, any thread */
+	FVerletClothDynamicData* Allocate()
+	{
+		FVerletClothDynamicData* Data = FreeList.Pop();
+		return Data ? Data : new FVerletClothDynamicData;
+	}
+
+	/** Gives back a snapshot that is not used anymore, any thread */
+	void Release(FVerletClothDynamicData* Data)
+	{
+		FreeList.Push(Data);
+	}
+
+private:
+
+	TLockFreePointerListLIFO<FVerletClothDynamicData> FreeList;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -103,22 +298,64 @@ public:
 		: FPrimitiveSceneProxy(Component)
 		, Material(NULL)
 		, DynamicData(NULL)
+		, DynamicDataPool(Component->DynamicDataPool)
 		, MaterialRelevance(Component->GetMaterialRelevance(GetScene().GetFeatureLevel()))
 		, NumSegments(Component->NumSegments)
 		, ClothWidth(Component->ClothWidth)
-		, NumSides(Component->NumSides)
+		, NumSides(FMath::Max(1, Component->NumSides))
+		, bGridMesh(!Component->Topology.HasRenderMesh())
+		, NumMeshVertices(0)
+		, ProxyMemory(0)
 	{
-		VertexBuffer.NumVerts = GetRequiredVertexCount();
-		IndexBuffer.NumIndices = GetRequiredIndexCount();
+		// Cloth meshes are rendered as they are
+		const FVerletClothTopology& Topology = Component->Topology;
+		if (!bGridMesh)
+		{
+			NumMeshVertices = Topology.RenderParticles.Num();
+			IndexBuffer.Indices = Topology.RenderIndices;
+		}
+
+		// Room for the vertices tearing adds
+		const int32 NumVerts = bGridMesh ? GetRequiredVertexCount() : FMath::Max(GetRequiredVertexCount(), Topology.MaxRenderVertices);
+
+		PositionBuffer.NumVerts = NumVerts;
+		PositionBuffer.Stride = sizeof(FVector);
+
+		TangentBuffer.NumVerts = NumVerts;
+		TangentBuffer.Stride = sizeof(FVerletClothTangentVertex);
+
+		StaticBuffer.NumVerts = NumVerts;
+		StaticBuffer.Stride = sizeof(FVerletClothStaticVertex);
+		StaticBuffer.bDynamic = false;
+
+		IndexBuffer.NumVerts = NumVerts;
+
+		BuildStaticMesh(Topology);
+
+		// GPU buffers and the copies kept to reinitialize them, none of them change size afterwards
+		ProxyMemory = NumVerts * (PositionBuffer.Stride + TangentBuffer.Stride + StaticBuffer.Stride) + IndexBuffer.Indices.Num() * IndexBuffer.GetStride()
+			+ StaticBuffer.InitialData.GetAllocatedSize() + IndexBuffer.Indices.GetAllocatedSize();
+		INC_MEMORY_STAT_BY(STAT_VerletCloth_ProxyMemory, ProxyMemory);
 
 		// Init vertex factory
-		VertexFactory.Init(&VertexBuffer);
+		VertexFactory.Init(&PositionBuffer, &TangentBuffer, &StaticBuffer);
 
 		// Enqueue initialization of render resource
-		BeginInitResource(&VertexBuffer);
+		BeginInitResource(&PositionBuffer);
+		BeginInitResource(&TangentBuffer);
+		BeginInitResource(&StaticBuffer);
 		BeginInitResource(&IndexBuffer);
 		BeginInitResource(&VertexFactory);
 
+		// Start from the current pose, the component only sends updates when the cloth moves
+		ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
+			FSendInitialClothDynamicData,
+			FVerletClothSceneProxy*, ClothSceneProxy, this,
+			FVerletClothDynamicData*, DynamicData, Component->CreateDynamicData(),
+			{
+				ClothSceneProxy->SetDynamicData_RenderThread(DynamicData);
+			});
+
 		// Grab material
 		Material = Component->GetMaterial(0);
 		if (Material == NULL)
@@ -129,24 +366,28 @@ public:
 
 	virtual ~FVerletClothSceneProxy()
 	{
-		VertexBuffer.ReleaseResource();
+		PositionBuffer.ReleaseResource();
+		TangentBuffer.ReleaseResource();
+		StaticBuffer.ReleaseResource();
 		IndexBuffer.ReleaseResource();
 		VertexFactory.ReleaseResource();
 
+		DEC_MEMORY_STAT_BY(STAT_VerletCloth_ProxyMemory, ProxyMemory);
+
 		if (DynamicData != NULL)
 		{
-			delete DynamicData;
+			DynamicDataPool->Release(DynamicData);
 		}
 	}
 
 	int32 GetRequiredVertexCount() const
 	{
-		return (NumSegments + 1) * (NumSides + 1);
+		return bGridMesh ? (NumSegments + 1) * (NumSides + 1) : NumMeshVertices;
 	}
 
 	int32 GetRequiredIndexCount() const
 	{
-		return (NumSegments * NumSides * 2) * 3;
+		return bGridMesh ? (NumSegments * NumSides * 2) * 3 : IndexBuffer.Indices.Num();
 	}
 
 	int32 GetVertIndex(int32 LineIdx, int32 Point) const
@@ -154,47 +395,43 @@ public:
 		return (LineIdx * (NumSides + 1)) + Point;
 	}
 
-	void BuildClothMesh(const TArray<FVerletClothDynamicHorizontalLine>& InLines, TArray<FDynamicMeshVertex>& OutVertices, TArray<int32>& OutIndices)
+	/** Builds the parts of the mesh that never change, UVs, colors and triangles */
+	void BuildStaticMesh(const FVerletClothTopology& Topology)
 	{
-		const int32 NumLines = InLines.Num();
-		const int32 SegmentCount = NumLines - 1;
+		SCOPE_CYCLE_COUNTER(STAT_VerletCloth_BuildStaticMesh);
 
-		// Build vertices				
+		const int32 NumLines = NumSegments + 1;
+		const int32 NumPoints = NumSides + 1;
+
+		StaticBuffer.InitialData.SetNumZeroed(StaticBuffer.NumVerts * sizeof(FVerletClothStaticVertex));
+		FVerletClothStaticVertex* StaticVertices = (FVerletClothStaticVertex*)StaticBuffer.InitialData.GetData();
+
+		// Triangles were copied from the topology
+		if (!bGridMesh)
+		{
+			for (int32 VertIdx = 0; VertIdx < GetRequiredVertexCount(); ++VertIdx)
+			{
+				StaticVertices[VertIdx].TextureCoordinate = Topology.RenderUVs[VertIdx];
+				StaticVertices[VertIdx].Color = Topology.RenderColors[VertIdx];
+			}
+			return;
+		}
 		for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
 		{
-			const float AlongFrac = (float)LineIdx / (float)SegmentCount;
-			const int32 PrevLineIdx = FMath::Max(LineIdx - 1, 0);
-			const int32 NextLineIdx = FMath::Min(LineIdx + 1, NumLines - 1);
-
-			int32 NumPoints = InLines[LineIdx].Points.Num();
+			const float AlongFrac = (float)LineIdx / (float)NumSegments;
 			for (int32 PointIdx = 0; PointIdx < NumPoints; PointIdx++)
 			{
-				FVector VerticalDir, RightDir, UpDir;
-				if(LineIdx==NextLineIdx)
-					VerticalDir = (InLines[LineIdx].Points[PointIdx] - InLines[PrevLineIdx].Points[PointIdx]).GetSafeNormal();
-				else
-					VerticalDir = (InLines[NextLineIdx].Points[PointIdx] - InLines[LineIdx].Points[PointIdx]).GetSafeNormal();
-								
-				const int32 PrevPointIdx = FMath::Max(PointIdx - 1, 0);
-				const int32 NextPointIdx = FMath::Min(PointIdx + 1, NumPoints - 1);
-				if (PointIdx == NextPointIdx)
-					RightDir = (InLines[LineIdx].Points[PointIdx] - InLines[LineIdx].Points[PrevPointIdx]).GetSafeNormal();
-				else
-					RightDir = (InLines[LineIdx].Points[NextPointIdx] - InLines[LineIdx].Points[PointIdx]).GetSafeNormal();
-				UpDir = (RightDir ^ VerticalDir).GetSafeNormal();
-
-				const float Frac = float(PointIdx) / float(NumPoints-1);
-				FDynamicMeshVertex Vert;
-				Vert.Position = InLines[LineIdx].Points[PointIdx];
+				const float Frac = float(PointIdx) / float(NumPoints - 1);
+				FVerletClothStaticVertex& Vert = StaticVertices[GetVertIndex(LineIdx, PointIdx)];
 				Vert.TextureCoordinate = FVector2D(Frac, AlongFrac);
 				Vert.Color = FColor::White;
-				Vert.SetTangents(RightDir, VerticalDir, UpDir);
-				OutVertices.Add(Vert);
 			}
 		}
 
 		// Build triangles
-		for (int32 SegIdx = 0; SegIdx < SegmentCount; SegIdx++)
+		TArray<uint32>& OutIndices = IndexBuffer.Indices;
+		OutIndices.Reserve(GetRequiredIndexCount());
+		for (int32 SegIdx = 0; SegIdx < NumSegments; SegIdx++)
 		{
 			for (int32 SideIdx = 0; SideIdx < NumSides; SideIdx++)
 			{
@@ -212,42 +449,76 @@ public:
 				OutIndices.Add(BR);
 			}
 		}
+		check(OutIndices.Num() == GetRequiredIndexCount());
+	}
+
+	/** Applies the tears of a snapshot, only the added vertices and the changed triangles are uploaded */
+	void ApplyMeshPatch_RenderThread(const FVerletClothMeshPatch& Patch)
+	{
+		// The proxy may have been created from a topology which already had some of the tears
+		const int32 FirstVertex = NumMeshVertices;
+		FVerletClothStaticVertex* StaticVertices = (FVerletClothStaticVertex*)StaticBuffer.InitialData.GetData();
+		for (int32 NewIdx = 0; NewIdx < Patch.SourceVertices.Num(); ++NewIdx)
+		{
+			const int32 VertIdx = Patch.FirstNewVertex + NewIdx;
+			if (VertIdx < NumMeshVertices)
+				continue;
+
+			check(VertIdx == NumMeshVertices && VertIdx < StaticBuffer.NumVerts);
+			StaticVertices[VertIdx] = StaticVertices[Patch.SourceVertices[NewIdx]];
+			NumMeshVertices++;
+		}
+		if (NumMeshVertices > FirstVertex)
+		{
+			StaticBuffer.UpdateVertices(FirstVertex, NumMeshVertices - FirstVertex);
+			INC_DWORD_STAT_BY(STAT_VerletCloth_BytesUploaded, (NumMeshVertices - FirstVertex) * StaticBuffer.Stride);
+		}
+
+		for (int32 PatchIdx = 0; PatchIdx < Patch.Triangles.Num(); ++PatchIdx)
+		{
+			const int32 TriangleIdx = Patch.Triangles[PatchIdx];
+			FMemory::Memcpy(&IndexBuffer.Indices[TriangleIdx * 3], &Patch.TriangleIndices[PatchIdx * 3], 3 * sizeof(uint32));
+			IndexBuffer.UpdateTriangle(TriangleIdx);
+		}
+		INC_DWORD_STAT_BY(STAT_VerletCloth_BytesUploaded, Patch.Triangles.Num() * 3 * IndexBuffer.GetStride());
 	}
 
 	/** Called on render thread to assign new dynamic data */
 	void SetDynamicData_RenderThread(FVerletClothDynamicData* NewDynamicData)
 	{
+		SCOPE_CYCLE_COUNTER(STAT_VerletCloth_Upload);
 		check(IsInRenderingThread());
 
-		// Free existing data if present
+		// Tears first, the positions include the vertices they add
+		if (!bGridMesh)
+			ApplyMeshPatch_RenderThread(NewDynamicData->MeshPatch);
+		check(NewDynamicData->Positions.Num() == GetRequiredVertexCount());
+
+		// Recycle the previous snapshot
 		if (DynamicData)
 		{
-			delete DynamicData;
+			DynamicDataPool->Release(DynamicData);
 			DynamicData = NULL;
 		}
 		DynamicData = NewDynamicData;
 
-		// Build mesh from cloth points
-		TArray<FDynamicMeshVertex> Vertices;
-		TArray<int32> Indices;
-
-		BuildClothMesh(NewDynamicData->HorizontalLines, Vertices, Indices);
+		// Only positions and tangents change every frame, UVs, colors and indices only when tearing.
+		// Both were built off the render thread, they are copied as they are.
+		const int32 NumVerts = GetRequiredVertexCount();
+		void* PositionBufferData = RHILockVertexBuffer(PositionBuffer.VertexBufferRHI, 0, NumVerts * sizeof(FVector), RLM_WriteOnly);
+		FMemory::Memcpy(PositionBufferData, NewDynamicData->Positions.GetData(), NumVerts * sizeof(FVector));
+		RHIUnlockVertexBuffer(PositionBuffer.VertexBufferRHI);
 
-		check(Vertices.Num() == GetRequiredVertexCount());
-		check(Indices.Num() == GetRequiredIndexCount());
+		void* TangentBufferData = RHILockVertexBuffer(TangentBuffer.VertexBufferRHI, 0, NumVerts * sizeof(FVerletClothTangentVertex), RLM_WriteOnly);
+		FMemory::Memcpy(TangentBufferData, NewDynamicData->Tangents.GetData(), NumVerts * sizeof(FVerletClothTangentVertex));
+		RHIUnlockVertexBuffer(TangentBuffer.VertexBufferRHI);
 
-		void* VertexBufferData = RHILockVertexBuffer(VertexBuffer.VertexBufferRHI, 0, Vertices.Num() * sizeof(FDynamicMeshVertex), RLM_WriteOnly);
-		FMemory::Memcpy(VertexBufferData, &Vertices[0], Vertices.Num() * sizeof(FDynamicMeshVertex));
-		RHIUnlockVertexBuffer(VertexBuffer.VertexBufferRHI);
-
-		void* IndexBufferData = RHILockIndexBuffer(IndexBuffer.IndexBufferRHI, 0, Indices.Num() * sizeof(int32), RLM_WriteOnly);
-		FMemory::Memcpy(IndexBufferData, &Indices[0], Indices.Num() * sizeof(int32));
-		RHIUnlockIndexBuffer(IndexBuffer.IndexBufferRHI);
+		INC_DWORD_STAT_BY(STAT_VerletCloth_BytesUploaded, NumVerts * (sizeof(FVector) + sizeof(FVerletClothTangentVertex)));
 	}
 
 	virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override
 	{
-		QUICK_SCOPE_CYCLE_COUNTER(STAT_ClothSceneProxy_GetDynamicMeshElements);
+		SCOPE_CYCLE_COUNTER(STAT_VerletCloth_GetDynamicMeshElements);
 
 		bool bWireframe = AllowDebugViewmodes() && ViewFamily.EngineShowFlags.Wireframe;
 
@@ -284,7 +555,7 @@ public:
 				BatchElement.FirstIndex = 0;
 				BatchElement.NumPrimitives = GetRequiredIndexCount() / 3;
 				BatchElement.MinVertexIndex = 0;
-				BatchElement.MaxVertexIndex = GetRequiredVertexCount();
+				BatchElement.MaxVertexIndex = GetRequiredVertexCount() - 1;
 				Mesh.ReverseCulling = IsLocalToWorldDeterminantNegative();
 				Mesh.bDisableBackfaceCulling = true;
 				Mesh.Type = PT_TriangleList;
@@ -296,14 +567,14 @@ public:
 				{
 					FLinearColor SimulationLineColor(1.0f, 0.f, 0.f);
 					FPrimitiveDrawInterface* PDI = Collector.GetPDI(ViewIndex);
-					int32 NumLines = DynamicData->HorizontalLines.Num() - 1;
+					int32 NumLines = DynamicData->NumLines - 1;
 					for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
 					{
-						int32 NumPoints = DynamicData->HorizontalLines[LineIdx].Points.Num();
+						int32 NumPoints = DynamicData->NumPointsPerLine;
 						for (int32 PointIdx = 0; PointIdx < NumPoints; ++PointIdx)
 						{
-							FVector PointA = GetLocalToWorld().TransformPosition(DynamicData->HorizontalLines[LineIdx].Points[PointIdx]);
-							FVector PointB = GetLocalToWorld().TransformPosition(DynamicData->HorizontalLines[LineIdx + 1].Points[PointIdx]);
+							FVector PointA = GetLocalToWorld().TransformPosition(DynamicData->GetPosition(LineIdx, PointIdx));
+							FVector PointB = GetLocalToWorld().TransformPosition(DynamicData->GetPosition(LineIdx + 1, PointIdx));
 							PDI->DrawLine(PointA, PointB, SimulationLineColor, SDPG_Foreground, 0.3f);
 						}						
 					}
@@ -329,24 +600,36 @@ public:
 
 	virtual uint32 GetMemoryFootprint(void) const override { return(sizeof(*this) + GetAllocatedSize()); }
 
-	uint32 GetAllocatedSize(void) const { return(FPrimitiveSceneProxy::GetAllocatedSize()); }
+	uint32 GetAllocatedSize(void) const { return(FPrimitiveSceneProxy::GetAllocatedSize() + StaticBuffer.InitialData.GetAllocatedSize() + IndexBuffer.Indices.GetAllocatedSize()); }
 
 private:
 
 	UMaterialInterface* Material;
-	FVerletClothVertexBuffer VertexBuffer;
+	FVerletClothVertexBuffer PositionBuffer;
+	FVerletClothVertexBuffer TangentBuffer;
+	FVerletClothVertexBuffer StaticBuffer;
 	FVerletClothIndexBuffer IndexBuffer;
 	FVerletClothVertexFactory VertexFactory;
 
 	FVerletClothDynamicData* DynamicData;
 
+	/** Where DynamicData goes back once replaced */
+	TSharedPtr<FVerletClothDynamicDataPool, ESPMode::ThreadSafe> DynamicDataPool;
+
 	FMaterialRelevance MaterialRelevance;
 
 	int32 NumSegments;
-
 	float ClothWidth;
 
 	int32 NumSides;
+
+	/** Rendering the grid, or the mesh of the topology with its own UVs and triangles */
+	bool bGridMesh;
+	/** Vertices of the mesh, the buffers have room for more as the cloth tears */
+	int32 NumMeshVertices;
+
+	/** Size of the buffers counted in the memory stats */
+	uint32 ProxyMemory;
 };
 
 
@@ -364,13 +647,78 @@ UVerletClothComponent::UVerletClothComponent( const FObjectInitializer& ObjectIn
 	Damping = 0.0f;
 	NumSegments = 10;
 	SolverIterations = 10;
+	SolverTolerance = 0.0f;
+	SolverRelaxation = 1.0f;
+	bLongRangeTethers = false;
+	TetherScale = 1.0f;
+	MaxSubstepsPerFrame = 4;
+	bInterpolateSubsteps = true;
+	BoundsPadding = 0.0f;
+	bParallelSolver = false;
+	bUseXPBD = false;
+	StretchCompliance = 0.0f;
+	ShearCompliance = 0.0f;
+	BendCompliance = 0.0f;
+	bAsyncSimulation = false;
 	NumSides = 1;
 	FixedLineCount = 1;
+	ClothMesh = NULL;
 	Gravity = FVector(0.0f, 0.0f, -980.0f);
+	WindGustStrength = 0.0f;
+	WindGustFrequency = 0.5f;
+	WindDrag = 1.0f;
+	WindLift = 0.0f;
 	SideAxis = ESideAxis::X;
 	CollisionPlane = ECollisionPlane::NONE;
+	bSelfCollision = false;
+	SelfCollisionThickness = 5.0f;
+	bTearable = false;
+	TearStretchRatio = 2.0f;
+	MaxTornParticles = 256;
 	ProcessWorldSpace = true;
 
+	BatchedClothLength = 0.0f;
+	BatchedClothWidth = 0.0f;
+	SolverMaxCorrection = 0.0f;
+	SolverRMSCorrection = 0.0f;
+	SolverIterationsRun = 0;
+	SimulatedMaxCorrection = 0.0f;
+	SimulatedRMSCorrection = 0.0f;
+	SimulatedIterationsRun = 0;
+	bSimulatedByManager = false;
+	AsyncReadIdx = 0;
+	LODHysteresis = 0.1f;
+	LODTransitionTime = 0.25f;
+	PinnedLineOffset = FVector::ZeroVector;
+	SimulatedFixedLineCount = 0;
+	CurrentLOD = 0;
+	LODBlendAlpha = 1.0f;
+	SimulatedBounds = FBox(0);
+	PaddedBounds = FBox(0);
+	LODBlendBounds = FBox(0);
+	bAllowSleeping = false;
+	SleepVelocityThreshold = 1.0f;
+	SleepMaxCorrection = 0.1f;
+	SleepSubstepCount = 30;
+	RestSubstepCount = 0;
+	bSleeping = false;
+	bSimulatedSleeping = false;
+	bThrottleWhenNotRendered = false;
+	NotRenderedTickInterval = 0.2f;
+	MaxCatchUpTime = 0.5f;
+	CatchUpSolverIterations = 3;
+	CatchUpSubstepRate = 20.0f;
+	bDeterministic = false;
+	DeterministicSubsteps = 1;
+	PreRollTime = 0.0f;
+	PreRollSubstepRate = 30.0f;
+	PreRollSolverIterations = 4;
+	ThrottledTime = 0.0f;
+	AccumulatedTime = 0.0f;
+	SimulationTime = 0.0f;
+	InterpolationAlpha = 1.0f;
+	ReportedSimulationMemory = 0;
+
 	SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
 }
 
@@ -378,6 +726,8 @@ void UVerletClothComponent::OnRegister()
 {
 	Super::OnRegister();
 
+	CompleteAsyncSimulation();
+
 	FVector SideAxisVector;
 	switch (SideAxis)
 	{
@@ -386,90 +736,878 @@ void UVerletClothComponent::OnRegister()
 	default: SideAxisVector = ProcessWorldSpace ? ComponentToWorld.TransformVector(FVector::UpVector) : FVector::UpVector; break;
 	}
 
-	const int32 NumLines = NumSegments + 1;
+	FVector CompLocation = GetComponentLocation();
 
-	HorizontalLines.Reset();
-	HorizontalLines.AddZeroed(NumLines);
+	// A cloth mesh replaces the grid settings
+	if (ClothMesh && Topology.BuildFromMesh(ClothMesh))
+	{
+		Particles.Init(1, Topology.NumParticles);
+		for (int32 Idx = 0; Idx < Topology.NumParticles; ++Idx)
+		{
+			const bool bFree = !Topology.Pinned[Idx];
+			const FVector& RestPosition = Topology.RestPositions[Idx];
+			const FVector Position = ProcessWorldSpace ? ComponentToWorld.TransformPosition(RestPosition) : RestPosition;
+			Particles.SetPosition(Idx, Position);
+			Particles.SetSavedPosition(Idx, bFree ? Position : RestPosition);
+			Particles.SetFree(Idx, bFree);
+		}
 
-	FixedLineCount = FMath::Min(FixedLineCount, NumLines);
-	for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+		PinnedLineOffset = FVector::ZeroVector;
+		SimulatedFixedLineCount = 0;
+	}
+	else
 	{
-		if (LineIdx < FixedLineCount)
-			HorizontalLines[LineIdx].bFree = false;
-		else
-			HorizontalLines[LineIdx].bFree = true;
+		const int32 NumLines = NumSegments + 1;
+		const int32 NumPoints = FMath::Max(1, NumSides) + 1;
+
+		// Nothing of a mesh the cloth was built from before is kept, BuildTopology builds the grid
+		Topology.Reset();
+
+		Particles.Init(NumLines, NumPoints);
+
+		FixedLineCount = FMath::Min(FixedLineCount, NumLines);
+
+		const FVector StartPosition = ProcessWorldSpace ? CompLocation : FVector::ZeroVector;
+		const FVector Delta = ProcessWorldSpace ? Gravity.GetSafeNormal() * ClothLength :
+			ComponentToWorld.InverseTransformVector(Gravity.GetSafeNormal()) * ClothLength;
+		const FVector HorizontalStart = SideAxisVector * (-ClothWidth / 2.0f);
+		const FVector HorizontalDelta = SideAxisVector * (ClothWidth / (NumPoints - 1));
+
+		for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+		{
+			const bool bFree = (LineIdx >= FixedLineCount);
+			const float Alpha = (float)LineIdx / (float)NumSegments;
+			const FVector RelativePosition = Alpha * Delta;
+			const FVector InitialPosition = StartPosition + RelativePosition;
+			for (int32 PointIdx = 0; PointIdx < NumPoints; PointIdx++)
+			{
+				const int32 Idx = Particles.GetIndex(LineIdx, PointIdx);
+				const FVector Position = InitialPosition + (HorizontalStart + (HorizontalDelta * PointIdx));
+				Particles.SetPosition(Idx, Position);
+				Particles.SetSavedPosition(Idx, bFree ? Position : RelativePosition);
+				Particles.SetFree(Idx, bFree);
+			}
+		}
+
+		PinnedLineOffset = Delta;
+		SimulatedFixedLineCount = FixedLineCount;
 	}
 
-	FVector CompLocation = GetComponentLocation();
-	const FVector StartPosition = ProcessWorldSpace ? CompLocation : FVector::ZeroVector;
-	const FVector Delta = ProcessWorldSpace ? Gravity.GetSafeNormal() * ClothLength :
-		ComponentToWorld.InverseTransformVector(Gravity.GetSafeNormal()) * ClothLength;
+	// Always start at full resolution, the first tick picks the LOD
+	CurrentLOD = 0;
+	LODBlendAlpha = 1.0f;
+	LODBlendPositions.Empty();
 
-	for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+	RestSubstepCount = 0;
+	bSleeping = false;
+	bSimulatedSleeping = false;
+	ThrottledTime = 0.0f;
+	AccumulatedTime = 0.0f;
+	SimulationTime = 0.0f;
+	InterpolationAlpha = 1.0f;
+	PaddedBounds = FBox(0);
+
+	if (!Solver.IsValid())
+		Solver = MakeShareable(new FVerletClothSolver(Particles, Topology, ConstraintBatches, ConstraintBatchTypes, Tethers));
+
+	BuildTopology();
+	OldComponentLocation = CompLocation;
+
+	// The pose is checked against the topology just built
+	const bool bRestPose = ApplyRestPose();
+
+	// Without a baked pose the cloth settles before it is first rendered
+	if (!bRestPose && PreRollTime > 0.0f && !bDeterministic)
+		PreRoll();
+
+	ResetAsyncPositions();
+	UpdateSimulationMemoryStat();
+
+	// Async simulation is kicked at the start of the frame and runs until the next one
+	SetTickGroup(bAsyncSimulation ? TG_PrePhysics : TG_PostUpdateWork);
+
+	if (ShouldUseSimulationManager() && !bSimulatedByManager)
 	{
-		FVerletClothHorizontalLine& Line = HorizontalLines[LineIdx];
-		Line.SetHorizontal(NumSides, ClothWidth);
-		Line.Damping = Damping;
-		const float Alpha = (float)LineIdx / (float)NumSegments;
-		const FVector RelativePosition = Alpha * Delta;
-		const FVector InitialPosition = StartPosition + RelativePosition;
-		if(Line.bFree)
-			Line.SetInitPosition(InitialPosition, FVector::ZeroVector, SideAxisVector);
-		else
-			Line.SetInitPosition(InitialPosition, RelativePosition, SideAxisVector);
+		FVerletClothSimulationManager::Get(GetWorld())->AddComponent(this);
+		bSimulatedByManager = true;
 	}
+}
 
-	OldComponentLocation = CompLocation;
+void UVerletClothComponent::OnUnregister()
+{
+	CompleteAsyncSimulation();
+
+	if (bSimulatedByManager)
+	{
+		if (FVerletClothSimulationManager* Manager = FVerletClothSimulationManager::Find(GetWorld()))
+			Manager->RemoveComponent(this);
+		bSimulatedByManager = false;
+	}
 
-	SetTickGroup(TG_PostUpdateWork);
+	DEC_MEMORY_STAT_BY(STAT_VerletCloth_SimulationMemory, ReportedSimulationMemory);
+	ReportedSimulationMemory = 0;
+
+	Super::OnUnregister();
+}
+
+void UVerletClothComponent::RegisterComponentTickFunctions(bool bRegister)
+{
+	// The simulation manager ticks managed components, they don't need a tick of their own
+	if (bRegister && ShouldUseSimulationManager())
+		return;
+
+	Super::RegisterComponentTickFunctions(bRegister);
+}
+
+bool UVerletClothComponent::ShouldUseSimulationManager() const
+{
+	UWorld* World = GetWorld();
+	return World && World->PersistentLevel && !IsTemplate() && FVerletClothSimulationManager::IsEnabled();
 }
 
 void UVerletClothComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	check( GetWorld()->GetWorldSettings() );
-	float TimeDilation = GetWorld()->GetWorldSettings()->GetEffectiveTimeDilation();
-	// Fixed step simulation at 60hz
-	float FixedTimeStep = FMath::Min( DeltaTime, (1.f / 60.0f) * TimeDilation);
-	float RemainingTime = DeltaTime;
-	
+	AWorldSettings* WorldSettings = GetWorld()->GetWorldSettings();
+
+	// Render last frame's result before touching the particles
+	if (bAsyncSimulation && CompleteAsyncSimulation())
+		FinishSimulation();
+
+	UpdateLOD(DeltaTime);
+	FVerletClothSimulationInput Input = GatherSimulationInput(DeltaTime, WorldSettings->GetEffectiveTimeDilation(), WorldSettings->GetGravityZ());
+	if (!ShouldSimulate(Input) || !ThrottleSimulation(Input))
+		return;
+
+	if (bAsyncSimulation)
+	{
+		AsyncSimulationEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([this, Input]()
+		{
+			SimulateAsync(Input);
+		}, GET_STATID(STAT_VerletCloth_AsyncTask), NULL, ENamedThreads::AnyThread);
+	}
+	else
+	{
+		Simulate(Input);
+		FinishSimulation();
+	}
+}
+
+FVerletClothSimulationInput UVerletClothComponent::GatherSimulationInput(float DeltaTime, float TimeDilation, float WorldGravityZ) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_GatherInput);
+
+	FVerletClothSimulationInput Input;
+	Input.ComponentToWorld = ComponentToWorld;
+	Input.DeltaTime = DeltaTime;
+	Input.TimeDilation = TimeDilation;
+	Input.WorldGravityZ = WorldGravityZ;
+	Input.CollisionPlane = CollisionPlane;
+
+	if (bUseLocalGravity)
+	{
+		Input.Gravity = ProcessWorldSpace ? ComponentToWorld.TransformVector(Gravity) : Gravity;
+	}
+	else
+	{
+		const FVector WorldGravity = FVector(0.0f, 0.0f, WorldGravityZ);
+		Input.Gravity = ProcessWorldSpace ? WorldGravity : ComponentToWorld.InverseTransformVector(WorldGravity);
+	}
+	Input.Wind = ProcessWorldSpace ? ComponentToWorld.TransformVector(Wind) : Wind;
+	Input.WindField = WindField;
+	Input.WindGustStrength = WindGustStrength;
+	Input.WindGustFrequency = WindGustFrequency;
+	GatherColliders(Input);
+
+	FVector SideAxisVector;
+	switch (SideAxis)
 	{
-		SCOPE_CYCLE_COUNTER( STAT_UpdateVerletClothTime );
-		while (RemainingTime >= FixedTimeStep)
+	case ESideAxis::X: SideAxisVector = FVector::ForwardVector; break;
+	case ESideAxis::Y: SideAxisVector = FVector::RightVector; break;
+	default: SideAxisVector = FVector::UpVector; break;
+	}
+	Input.bWorldSpace = ProcessWorldSpace;
+	Input.SideAxis = ProcessWorldSpace ? ComponentToWorld.TransformVector(SideAxisVector) : SideAxisVector;
+	Input.ClothWidth = ClothWidth;
+
+	const FVerletClothLODSettings* LOD = (CurrentLOD > 0 && CurrentLOD <= LODs.Num()) ? &LODs[CurrentLOD - 1] : NULL;
+	Input.Settings = GetSimulationSettings();
+	Input.Settings.SolverIterations = LOD ? LOD->SolverIterations : SolverIterations;
+	Input.SubstepRate = LOD ? LOD->SubstepRate : 60.0f;
+	Input.MaxSubsteps = MaxSubstepsPerFrame;
+	Input.DeterministicSubsteps = bDeterministic ? FMath::Max(DeterministicSubsteps, 1) : 0;
+	Input.bInterpolateSubsteps = bInterpolateSubsteps && !bDeterministic;
+
+	// Sleeping stops the render updates, so a LOD blend in progress has to finish first.
+	// Wind changing over time never lets the cloth rest, and its changes cannot be seen by comparing inputs.
+	const bool bWindChanging = WindField.IsValid() || (WindGustStrength > 0.0f && !Wind.IsNearlyZero());
+	Input.bAllowSleeping = bAllowSleeping && !bDeterministic && LODBlendAlpha >= 1.0f && !bWindChanging;
+	Input.SleepVelocityThreshold = SleepVelocityThreshold;
+	Input.SleepMaxCorrection = SleepMaxCorrection;
+	Input.SleepSubstepCount = SleepSubstepCount;
+	Input.bTearable = bTearable;
+	Input.TearStretchRatio = TearStretchRatio;
+	return Input;
+}
+
+void UVerletClothComponent::Simulate(const FVerletClothSimulationInput& Input)
+{
+	// Fixed step simulation, 60hz unless the LOD lowers it
+	float FixedTimeStep;
+	const int32 NumSubsteps = FVerletClothSolver::GetFrameSubsteps(Input.DeltaTime, Input.TimeDilation, Input.SubstepRate, Input.MaxSubsteps, Input.DeterministicSubsteps, AccumulatedTime, FixedTimeStep);
+	if (FixedTimeStep <= 0.0f)
+		return;
+
+	// Named after the component on timeline profilers
+	FScopeCycleCounterUObject ComponentScope(this);
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_Simulate);
+	INC_DWORD_STAT(STAT_VerletCloth_SimulatedComponents);
+	INC_DWORD_STAT_BY(STAT_VerletCloth_Particles, Particles.NumParticles);
+	INC_DWORD_STAT_BY(STAT_VerletCloth_Constraints, Topology.Constraints.Num() + Tethers.Num());
+	INC_DWORD_STAT_BY(STAT_VerletCloth_Substeps, NumSubsteps);
+
+	FVerletClothSubstepInput SubstepInput;
+	SubstepInput.TimeStep = FixedTimeStep;
+	SubstepInput.Gravity = Input.Gravity;
+	SubstepInput.Colliders = Input.Colliders.GetData();
+	SubstepInput.NumColliders = Input.Colliders.Num();
+
+	// Wind fields work in world space, the built in one blows Wind with gusts. No air resistance without wind either.
+	const FVector WorldWind = Input.bWorldSpace ? Input.Wind : Input.ComponentToWorld.TransformVector(Input.Wind);
+	const FVerletClothGustWind GustWind(WorldWind, Input.WindGustStrength, Input.WindGustFrequency);
+	const FVerletClothWindField& WorldWindField = Input.WindField.IsValid() ? *Input.WindField : static_cast<const FVerletClothWindField&>(GustWind);
+	const FVerletClothComponentSpaceWind ComponentSpaceWind(WorldWindField, Input.ComponentToWorld, WindPositions);
+	if (Input.WindField.IsValid() || !Input.Wind.IsNearlyZero())
+		SubstepInput.WindField = Input.bWorldSpace ? &WorldWindField : &ComponentSpaceWind;
+
+	if (Input.CollisionPlane != ECollisionPlane::NONE)
+	{
+		const FVector Origin = Input.bWorldSpace ? Input.ComponentToWorld.GetLocation() : FVector::ZeroVector;
+		const FQuat Rotation = Input.bWorldSpace ? Input.ComponentToWorld.GetRotation() : FQuat::Identity;
+		switch (Input.CollisionPlane)
 		{
-			VerletIntegrate( FixedTimeStep );
-			SolveConstraints();
-			ProcessCollision();
-			RemainingTime -= FixedTimeStep;
+		case ECollisionPlane::XY: SubstepInput.CollisionPlane = FPlane( Origin, Rotation.GetAxisZ() ); break;
+		case ECollisionPlane::YZ: SubstepInput.CollisionPlane = FPlane( Origin, Rotation.GetAxisX() ); break;
+		case ECollisionPlane::ZX: SubstepInput.CollisionPlane = FPlane( Origin, Rotation.GetAxisY() ); break;
 		}
+		SubstepInput.bCollisionPlane = true;
 	}
 
+	if (Topology.bGrid)
+	{
+		SubstepInput.NumPinnedLines = SimulatedFixedLineCount;
+		SubstepInput.PinnedLineDelta = Input.SideAxis * (Input.ClothWidth / (Particles.NumPointsPerLine - 1));
+	}
+	else
+	{
+		// Pinned mesh particles follow the component, saved position is their rest position
+		PinnedPositions.SetNumUninitialized(Topology.PinnedParticles.Num());
+		for (int32 PinnedIdx = 0; PinnedIdx < Topology.PinnedParticles.Num(); ++PinnedIdx)
+		{
+			const FVector RestPosition = Particles.GetSavedPosition(Topology.PinnedParticles[PinnedIdx]);
+			PinnedPositions[PinnedIdx] = Input.bWorldSpace ? Input.ComponentToWorld.TransformPosition(RestPosition) : RestPosition;
+		}
+		SubstepInput.PinnedPositions = PinnedPositions.GetData();
+	}
+
+	const FVector HorizontalStart = Input.SideAxis * (-Input.ClothWidth / 2.0f);
+	for (int32 SubstepIdx = 0; SubstepIdx < NumSubsteps; SubstepIdx++)
+	{
+		// Fixed lines follow the component, saved position is relative to it
+		const FVector CompLocation = Input.ComponentToWorld.GetLocation();
+		const FVector CenterLocation = Input.bWorldSpace ? CompLocation : Input.ComponentToWorld.InverseTransformVector(CompLocation - OldComponentLocation);
+		OldComponentLocation = CompLocation;
+		SubstepInput.PinnedLineStart = CenterLocation + HorizontalStart;
+
+		SubstepInput.Time = SimulationTime;
+		Solver->Substep(Input.Settings, SubstepInput);
+		SimulationTime += FixedTimeStep;
+
+		// Free particles moved less than the threshold during the whole substep, and the solver left little error in the constraints
+		if (Input.bAllowSleeping)
+		{
+			const float MaxStep = Input.SleepVelocityThreshold * FixedTimeStep;
+			float MaxCorrection, RMSCorrection;
+			int32 IterationsRun;
+			Solver->GetResidual(MaxCorrection, RMSCorrection, IterationsRun);
+			const bool bAtRest = MaxCorrection <= Input.SleepMaxCorrection && VerletClothKernels::GetMaxSquaredStep(Particles) <= MaxStep * MaxStep;
+			RestSubstepCount = bAtRest ? RestSubstepCount + 1 : 0;
+		}
+	}
+
+	// Published for GetSolverResidual by FinishSimulation
+	Solver->GetResidual(SimulatedMaxCorrection, SimulatedRMSCorrection, SimulatedIterationsRun);
+
+	if (Input.bTearable)
+		FindTears(Input.TearStretchRatio);
+
+	// Rendering one substep behind lets the leftover time move the cloth smoothly between the last two states
+	InterpolationAlpha = Input.bInterpolateSubsteps ? FMath::Clamp(AccumulatedTime / FixedTimeStep, 0.0f, 1.0f) : 1.0f;
+
+	// Bounds are gathered here on the simulating thread, interpolated positions lie between the saved and current ones
+	SimulatedBounds = VerletClothKernels::ComputeBounds(Particles, InterpolationAlpha < 1.0f);
+
+	// Published by FinishSimulation, a wake up on the game thread meanwhile waits for this simulation first
+	bSimulatedSleeping = Input.bAllowSleeping && RestSubstepCount >= Input.SleepSubstepCount;
+	if (bSimulatedSleeping)
+		SleepInput = Input;
+}
+
+bool UVerletClothComponent::ShouldSimulate(const FVerletClothSimulationInput& Input)
+{
+	if (!bSleeping)
+		return true;
+
+	// A LOD switch while asleep starts a blend which only moves on with the simulation, as does wind starting to change
+	bool bInputChanged = !Input.bAllowSleeping
+		|| !Input.ComponentToWorld.Equals(SleepInput.ComponentToWorld)
+		|| !Input.Gravity.Equals(SleepInput.Gravity)
+		|| !Input.Wind.Equals(SleepInput.Wind)
+		|| Input.WindField != SleepInput.WindField
+		|| Input.CollisionPlane != SleepInput.CollisionPlane
+		|| Input.Colliders.Num() != SleepInput.Colliders.Num();
+	for (int32 ColliderIdx = 0; !bInputChanged && ColliderIdx < Input.Colliders.Num(); ++ColliderIdx)
+		bInputChanged = !Input.Colliders[ColliderIdx].Equals(SleepInput.Colliders[ColliderIdx]);
+
+	if (bInputChanged)
+		WakeUp();
+
+	if (bSleeping)
+	{
+		INC_DWORD_STAT(STAT_VerletCloth_SleepingComponents);
+	}
+	return !bSleeping;
+}
+
+bool UVerletClothComponent::ThrottleSimulation(FVerletClothSimulationInput& Input)
+{
+	if (!bThrottleWhenNotRendered || bDeterministic)
+	{
+		ThrottledTime = 0.0f;
+		return true;
+	}
+
+	// Rendered during the last frame or two
+	const bool bRendered = GetWorld()->TimeSince(LastRenderTime) <= FMath::Max(0.1f, Input.DeltaTime * 2.0f);
+	if (bRendered && ThrottledTime == 0.0f)
+		return true;
+
+	ThrottledTime += Input.DeltaTime;
+	if (!bRendered && (NotRenderedTickInterval <= 0.0f || ThrottledTime < NotRenderedTickInterval))
+	{
+		INC_DWORD_STAT(STAT_VerletCloth_ThrottledComponents);
+		return false;
+	}
+
+	// Catch up on the skipped time with larger steps and fewer iterations, bounded so a long pause does not stall the frame
+	Input.DeltaTime = FMath::Min(ThrottledTime, MaxCatchUpTime);
+	Input.MaxSubsteps = 0;
+	Input.Settings.SolverIterations = FMath::Min(Input.Settings.SolverIterations, CatchUpSolverIterations);
+	Input.SubstepRate = FMath::Min(Input.SubstepRate, CatchUpSubstepRate);
+	ThrottledTime = 0.0f;
+	return true;
+}
+
+void UVerletClothComponent::WakeUp()
+{
+	// The simulation in flight may be about to fall asleep, it is published first so the wake up is not lost
+	if (CompleteAsyncSimulation())
+		FinishSimulation();
+
+	bSleeping = false;
+	bSimulatedSleeping = false;
+	RestSubstepCount = 0;
+}
+
+void UVerletClothComponent::SetWindField(TSharedPtr<FVerletClothWindField, ESPMode::ThreadSafe> InWindField)
+{
+	WindField = InWindField;
+}
+
+void UVerletClothComponent::GetSolverResidual(float& MaxCorrection, float& RMSCorrection, int32& IterationsRun) const
+{
+	MaxCorrection = SolverMaxCorrection;
+	RMSCorrection = SolverRMSCorrection;
+	IterationsRun = SolverIterationsRun;
+}
+
+void UVerletClothComponent::CaptureSnapshot(TArray<uint8>& Data)
+{
+	// Captured once the simulation running on a worker thread is done
+	if (CompleteAsyncSimulation())
+		FinishSimulation();
+
+	FVerletClothSnapshot Snapshot;
+	Snapshot.Time = SimulationTime;
+	GetSnapshotParams(Snapshot.Params);
+	Snapshot.Capture(Particles);
+	Snapshot.Save(Data);
+}
+
+bool UVerletClothComponent::RestoreSnapshot(const TArray<uint8>& Data, int32& Offset)
+{
+	if (CompleteAsyncSimulation())
+		FinishSimulation();
+
+	FVerletClothSnapshot Snapshot;
+	int32 SnapshotOffset = Offset;
+	if (!Snapshot.Load(Data, SnapshotOffset) || !Snapshot.Restore(Particles))
+		return false;
+	Offset = SnapshotOffset;
+
+	const FVerletClothSnapshotParams& Params = Snapshot.Params;
+	SolverIterations = Params.Settings.SolverIterations;
+	SolverTolerance = Params.Settings.SolverTolerance;
+	SolverRelaxation = Params.Settings.SolverRelaxation;
+	Damping = Params.Settings.Damping;
+	WindDrag = Params.Settings.WindDrag;
+	WindLift = Params.Settings.WindLift;
+	bUseXPBD = Params.Settings.bUseXPBD;
+	StretchCompliance = Params.Settings.Compliance[FVerletClothTopology::Structural];
+	ShearCompliance = Params.Settings.Compliance[FVerletClothTopology::Shear];
+	BendCompliance = Params.Settings.Compliance[FVerletClothTopology::Bend];
+	bSelfCollision = Params.Settings.SelfCollisionThickness > 0.0f;
+	if (bSelfCollision)
+		SelfCollisionThickness = Params.Settings.SelfCollisionThickness;
+
+	const bool bTethers = Params.TetherScale > 0.0f;
+	if (bTethers != bLongRangeTethers || (bTethers && TetherScale != Params.TetherScale))
+	{
+		bLongRangeTethers = bTethers;
+		if (bTethers)
+			TetherScale = Params.TetherScale;
+		BuildSolverBatches();
+	}
+
+	// Replays start on a substep boundary
+	SimulationTime = Snapshot.Time;
+	AccumulatedTime = 0.0f;
+	InterpolationAlpha = 1.0f;
+	WakeUp();
+	ResetAsyncPositions();
+	MarkRenderDynamicDataDirty();
+	return true;
+}
+
+bool UVerletClothComponent::CaptureRestPose()
+{
+	if (CompleteAsyncSimulation())
+		FinishSimulation();
+
+	// Registering always starts at full resolution and untorn
+	int32 NumLines, NumPoints;
+	GetSimulationGridSize(0, NumLines, NumPoints);
+	if (Topology.bTorn || Particles.NumLines != NumLines || Particles.NumPointsPerLine != NumPoints)
+		return false;
+
+	TArray<FVector> Positions;
+	Positions.SetNumUninitialized(Particles.NumParticles);
+	for (int32 Idx = 0; Idx < Particles.NumParticles; ++Idx)
+	{
+		const FVector Position = Particles.GetPosition(Idx);
+		Positions[Idx] = ProcessWorldSpace ? ComponentToWorld.InverseTransformPosition(Position) : Position;
+	}
+
+	FVerletClothRestPose Pose;
+	Pose.Capture(Positions, Particles.NumLines, Particles.NumPointsPerLine);
+	Pose.TopologyHash = GetRestPoseTopologyHash();
+
+	Modify();
+	RestPose.Reset();
+	Pose.Save(RestPose);
+	return true;
+}
+
+void UVerletClothComponent::ClearRestPose()
+{
+	Modify();
+	RestPose.Empty();
+}
+
+bool UVerletClothComponent::ApplyRestPose()
+{
+	if (RestPose.Num() == 0)
+		return false;
+
+	FVerletClothRestPose Pose;
+	int32 Offset = 0;
+	if (!Pose.Load(RestPose, Offset) || !Pose.Matches(Particles, GetRestPoseTopologyHash()))
+		return false;
+
+	// Pinned particles are already where the component holds them, free ones start at rest
+	for (int32 Idx = 0; Idx < Particles.NumParticles; ++Idx)
+	{
+		if (!Particles.IsFree(Idx))
+			continue;
+
+		const FVector Position = ProcessWorldSpace ? ComponentToWorld.TransformPosition(Pose.GetPosition(Idx)) : Pose.GetPosition(Idx);
+		Particles.SetPosition(Idx, Position);
+		Particles.SetSavedPosition(Idx, Position);
+	}
+	return true;
+}
+
+uint32 UVerletClothComponent::GetRestPoseTopologyHash() const
+{
+	// Rest lengths and pins cover the grid size and the mesh contents, the settings cover changes that keep them
+	const FVerletClothConstraintBatch& Constraints = Topology.Constraints;
+	uint32 Hash = FCrc::MemCrc32(Constraints.RestLength.GetData(), Constraints.RestLength.Num() * sizeof(float));
+	Hash = FCrc::MemCrc32(Topology.Pinned.GetData(), Topology.Pinned.Num() * sizeof(bool), Hash);
+	Hash = HashCombine(Hash, GetTypeHash(ClothLength));
+	Hash = HashCombine(Hash, GetTypeHash(ClothWidth));
+	Hash = HashCombine(Hash, GetTypeHash((uint8)SideAxis));
+	Hash = HashCombine(Hash, GetTypeHash(FixedLineCount));
+	return HashCombine(Hash, ClothMesh ? GetTypeHash(ClothMesh->GetPathName()) : 0);
+}
+
+void UVerletClothComponent::PreRoll()
+{
+	UWorld* World = GetWorld();
+	AWorldSettings* WorldSettings = World ? World->GetWorldSettings() : NULL;
+	if (WorldSettings == NULL)
+		return;
+
+	// One long frame with larger steps and fewer iterations, like a catch-up
+	FVerletClothSimulationInput Input = GatherSimulationInput(PreRollTime, 1.0f, WorldSettings->GetGravityZ());
+	Input.MaxSubsteps = 0;
+	Input.Settings.SolverIterations = FMath::Min(Input.Settings.SolverIterations, PreRollSolverIterations);
+	Input.SubstepRate = FMath::Min(Input.SubstepRate, PreRollSubstepRate);
+	Simulate(Input);
+
+	// The first tick starts on a substep boundary
+	AccumulatedTime = 0.0f;
+	InterpolationAlpha = 1.0f;
+}
+
+void UVerletClothComponent::SimulateAsync(const FVerletClothSimulationInput& Input)
+{
+	Simulate(Input);
+
+	TArray<FVector>& BackBuffer = AsyncPositions[1 - AsyncReadIdx];
+	for (int32 Idx = 0; Idx < BackBuffer.Num(); ++Idx)
+		BackBuffer[Idx] = GetInterpolatedPosition(Idx);
+	AsyncBounds[1 - AsyncReadIdx] = SimulatedBounds;
+}
+
+bool UVerletClothComponent::CompleteAsyncSimulation()
+{
+	if (!AsyncSimulationEvent.GetReference())
+		return false;
+
+	if (!AsyncSimulationEvent->IsComplete())
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(AsyncSimulationEvent, ENamedThreads::GameThread);
+	AsyncSimulationEvent = NULL;
+
+	AsyncReadIdx = 1 - AsyncReadIdx;
+	return true;
+}
+
+FVector UVerletClothComponent::GetRenderedPosition(int32 Idx) const
+{
+	// Async buffers are only allocated in async mode
+	return AsyncPositions[AsyncReadIdx].Num() > 0 ? AsyncPositions[AsyncReadIdx][Idx] : GetInterpolatedPosition(Idx);
+}
+
+FVector UVerletClothComponent::GetInterpolatedPosition(int32 Idx) const
+{
+	// Saved position is the previous substep for free particles. Pinned ones are set from the same transform
+	// for every substep of a frame, so they are rendered where they are.
+	const FVector Position = Particles.GetPosition(Idx);
+	if (InterpolationAlpha >= 1.0f || !Particles.IsFree(Idx))
+		return Position;
+
+	return FMath::Lerp(Particles.GetSavedPosition(Idx), Position, InterpolationAlpha);
+}
+
+void UVerletClothComponent::ResetAsyncPositions()
+{
+	SimulatedBounds = VerletClothKernels::ComputeBounds(Particles, false);
+
+	// Both async buffers start from the current pose
+	for (int32 BufferIdx = 0; BufferIdx < 2; BufferIdx++)
+	{
+		AsyncPositions[BufferIdx].SetNumUninitialized(bAsyncSimulation ? Particles.NumParticles : 0);
+		for (int32 Idx = 0; Idx < AsyncPositions[BufferIdx].Num(); ++Idx)
+			AsyncPositions[BufferIdx][Idx] = Particles.GetPosition(Idx);
+		AsyncBounds[BufferIdx] = SimulatedBounds;
+	}
+}
+
+const FBox& UVerletClothComponent::GetRenderedBounds() const
+{
+	return AsyncPositions[AsyncReadIdx].Num() > 0 ? AsyncBounds[AsyncReadIdx] : SimulatedBounds;
+}
+
+/** Bilinear interpolation of a grid of points laid out line by line, at fractional line and point coordinates */
+template<typename GetPointType>
+static FVector SampleGrid(int32 NumLines, int32 NumPoints, float Line, float Point, const GetPointType& GetPoint)
+{
+	const int32 LineA = FMath::Clamp(FMath::FloorToInt(Line), 0, NumLines - 2);
+	const int32 PointA = FMath::Clamp(FMath::FloorToInt(Point), 0, NumPoints - 2);
+	const float LineAlpha = Line - LineA;
+	const float PointAlpha = Point - PointA;
+
+	const int32 Idx = LineA * NumPoints + PointA;
+	const FVector Top = FMath::Lerp(GetPoint(Idx), GetPoint(Idx + 1), PointAlpha);
+	const FVector Bottom = FMath::Lerp(GetPoint(Idx + NumPoints), GetPoint(Idx + NumPoints + 1), PointAlpha);
+	return FMath::Lerp(Top, Bottom, LineAlpha);
+}
+
+int32 UVerletClothComponent::GetNumRenderedVertices() const
+{
+	return Topology.HasRenderMesh() ? Topology.RenderParticles.Num() : (NumSegments + 1) * (FMath::Max(1, NumSides) + 1);
+}
+
+void UVerletClothComponent::GetRenderedVertices(FVector* OutPositions) const
+{
+	if (Topology.HasRenderMesh())
+	{
+		// Mesh vertices split along seams or tears follow the same particle
+		for (int32 VertIdx = 0; VertIdx < Topology.RenderParticles.Num(); ++VertIdx)
+		{
+			const FVector Position = GetRenderedPosition(Topology.RenderParticles[VertIdx]);
+			OutPositions[VertIdx] = ProcessWorldSpace ? ComponentToWorld.InverseTransformPosition(Position) : Position;
+		}
+		return;
+	}
+
+	const int32 NumLines = NumSegments + 1;
+	const int32 NumPoints = FMath::Max(1, NumSides) + 1;
+	const bool bFullGrid = (Particles.NumLines == NumLines && Particles.NumPointsPerLine == NumPoints);
+	const float LineScale = (float)(Particles.NumLines - 1) / (float)(NumLines - 1);
+	const float PointScale = (float)(Particles.NumPointsPerLine - 1) / (float)(NumPoints - 1);
+	const bool bBlend = LODBlendAlpha < 1.0f && LODBlendPositions.Num() == NumLines * NumPoints;
+
+	auto GetPoint = [this](int32 Idx) { return GetRenderedPosition(Idx); };
+
+	for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+	{
+		for (int32 PointIdx = 0; PointIdx < NumPoints; ++PointIdx)
+		{
+			FVector Position = bFullGrid ? GetRenderedPosition(Particles.GetIndex(LineIdx, PointIdx)) :
+				SampleGrid(Particles.NumLines, Particles.NumPointsPerLine, LineIdx * LineScale, PointIdx * PointScale, GetPoint);
+			if (ProcessWorldSpace)
+				Position = ComponentToWorld.InverseTransformPosition(Position);
+
+			const int32 VertIdx = LineIdx * NumPoints + PointIdx;
+			OutPositions[VertIdx] = bBlend ? FMath::Lerp(LODBlendPositions[VertIdx], Position, LODBlendAlpha) : Position;
+		}
+	}
+}
+
+void UVerletClothComponent::UpdateLOD(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_UpdateLOD);
+
+	if (LODBlendAlpha < 1.0f)
+		LODBlendAlpha = LODTransitionTime > 0.0f ? FMath::Min(LODBlendAlpha + DeltaTime / LODTransitionTime, 1.0f) : 1.0f;
+
+	// Grid rest lengths are baked in the topology, torn grids keep theirs
+	if (Topology.bGrid && !Topology.bTorn && (BatchedClothLength != ClothLength || BatchedClothWidth != ClothWidth))
+		BuildTopology();
+
+	if (LODs.Num() == 0 && CurrentLOD == 0)
+		return;
+
+	// Deterministic runs stay on the level they are at
+	if (bDeterministic)
+		return;
+
+	UWorld* World = GetWorld();
+	if (World == NULL || World->ViewLocationsRenderedLastFrame.Num() == 0)
+		return;
+
+	// Screen size from the closest view, the same measure as mesh LODs with a 90 degrees field of view
+	float MinDistanceSquared = MAX_flt;
+	for (const FVector& ViewLocation : World->ViewLocationsRenderedLastFrame)
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(Bounds.Origin, ViewLocation));
+	const float ScreenSize = Bounds.SphereRadius / FMath::Max(FMath::Sqrt(MinDistanceSquared), 1.0f);
+
+	int32 NewLOD = 0;
+	for (int32 LODIdx = 0; LODIdx < LODs.Num(); ++LODIdx)
+	{
+		// Going back to a finer level needs some margin
+		const float Threshold = LODs[LODIdx].ScreenSize * (CurrentLOD > LODIdx ? 1.0f + LODHysteresis : 1.0f);
+		if (ScreenSize < Threshold)
+			NewLOD = LODIdx + 1;
+	}
+
+	if (NewLOD == CurrentLOD)
+		return;
+
+	int32 NumLines, NumPoints;
+	GetSimulationGridSize(NewLOD, NumLines, NumPoints);
+	if (NumLines != Particles.NumLines || NumPoints != Particles.NumPointsPerLine)
+	{
+		// Blend from what is on screen right now
+		TArray<FVector> BlendPositions;
+		BlendPositions.SetNumUninitialized(GetNumRenderedVertices());
+		GetRenderedVertices(BlendPositions.GetData());
+		LODBlendBounds = FBox(BlendPositions);
+		LODBlendPositions = MoveTemp(BlendPositions);
+		LODBlendAlpha = 0.0f;
+
+		ResampleParticles(NumLines, NumPoints);
+	}
+
+	CurrentLOD = NewLOD;
+}
+
+void UVerletClothComponent::GetSimulationGridSize(int32 LODIdx, int32& OutNumLines, int32& OutNumPoints) const
+{
+	// Meshes and grids rendered from their topology are simulated as they are
+	if (Topology.HasRenderMesh())
+	{
+		OutNumLines = Particles.NumLines;
+		OutNumPoints = Particles.NumPointsPerLine;
+		return;
+	}
+
+	const int32 Reduction = (LODIdx > 0 && LODIdx <= LODs.Num()) ? FMath::Max(1, LODs[LODIdx - 1].GridReduction) : 1;
+	OutNumLines = FMath::DivideAndRoundUp(NumSegments, Reduction) + 1;
+	OutNumPoints = FMath::DivideAndRoundUp(FMath::Max(1, NumSides), Reduction) + 1;
+}
+
+void UVerletClothComponent::ResampleParticles(int32 NumLines, int32 NumPoints)
+{
+	const FVerletClothParticles Old = Particles;
+
+	// Pinned particles keep an offset instead of their previous position, they are sampled at rest
+	auto GetOldPosition = [&Old](int32 Idx) { return Old.GetPosition(Idx); };
+	auto GetOldPrevious = [&Old](int32 Idx) { return Old.IsFree(Idx) ? Old.GetSavedPosition(Idx) : Old.GetPosition(Idx); };
+
+	Particles.Init(NumLines, NumPoints);
+	SimulatedFixedLineCount = FixedLineCount > 0 ? FMath::Min(1 + FMath::RoundToInt((FixedLineCount - 1) * (NumLines - 1) / (float)NumSegments), NumLines) : 0;
+
+	const float LineScale = (float)(Old.NumLines - 1) / (float)(NumLines - 1);
+	const float PointScale = (float)(Old.NumPointsPerLine - 1) / (float)(NumPoints - 1);
+	for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+	{
+		const bool bFree = (LineIdx >= SimulatedFixedLineCount);
+		const FVector RelativePosition = PinnedLineOffset * ((float)LineIdx / (float)(NumLines - 1));
+		for (int32 PointIdx = 0; PointIdx < NumPoints; PointIdx++)
+		{
+			const int32 Idx = Particles.GetIndex(LineIdx, PointIdx);
+			const float OldLine = LineIdx * LineScale;
+			const float OldPoint = PointIdx * PointScale;
+			Particles.SetPosition(Idx, SampleGrid(Old.NumLines, Old.NumPointsPerLine, OldLine, OldPoint, GetOldPosition));
+			Particles.SetSavedPosition(Idx, bFree ? SampleGrid(Old.NumLines, Old.NumPointsPerLine, OldLine, OldPoint, GetOldPrevious) : RelativePosition);
+			Particles.SetFree(Idx, bFree);
+		}
+	}
+
+	BuildTopology();
+	ResetAsyncPositions();
+	WakeUp();
+}
+
+void UVerletClothComponent::FinishSimulation()
+{
+	ApplyTears();
+	UpdateSimulationMemoryStat();
+
+	SolverMaxCorrection = SimulatedMaxCorrection;
+	SolverRMSCorrection = SimulatedRMSCorrection;
+	SolverIterationsRun = SimulatedIterationsRun;
+	bSleeping = bSimulatedSleeping;
+
 	// Need to send new data to render thread
 	MarkRenderDynamicDataDirty();
 
-	// Call this because bounds have changed
-	UpdateComponentToWorld();
+	// Padded bounds only change once the cloth leaves them
+	const FBox& RenderedBounds = GetRenderedBounds();
+	if (BoundsPadding > 0.0f)
+	{
+		if (PaddedBounds.IsValid && PaddedBounds.IsInside(RenderedBounds) && LODBlendAlpha >= 1.0f)
+			return;
+		PaddedBounds = RenderedBounds.ExpandBy(BoundsPadding);
+	}
+
+	// Bounds have changed, the transform itself has not
+	UpdateBounds();
+	MarkRenderTransformDirty();
 }
 
-void UVerletClothComponent::SendRenderDynamicData_Concurrent()
+FVerletClothDynamicData* UVerletClothComponent::CreateDynamicData() const
 {
-	if (SceneProxy)
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_PackDynamicData);
+
+	// Grab a recycled snapshot, its positions keep their allocation between frames
+	FVerletClothDynamicData* DynamicData = DynamicDataPool->Allocate();
+	DynamicData->NumLines = Topology.HasRenderMesh() ? 1 : NumSegments + 1;
+	DynamicData->NumPointsPerLine = Topology.HasRenderMesh() ? GetNumRenderedVertices() : FMath::Max(1, NumSides) + 1;
+	DynamicData->Positions.SetNumUninitialized(DynamicData->NumLines * DynamicData->NumPointsPerLine);
+	DynamicData->MeshPatch.Reset();
+
+	// Current positions in component space, at render resolution
+	GetRenderedVertices(DynamicData->Positions.GetData());
+	BuildRenderedTangents(*DynamicData);
+	return DynamicData;
+}
+
+void UVerletClothComponent::BuildRenderedTangents(FVerletClothDynamicData& Data) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_BuildTangents);
+
+	Data.Tangents.SetNumUninitialized(Data.Positions.Num());
+
+	if (!Topology.HasRenderMesh())
 	{
-		// Allocate cloth dynamic data
-		FVerletClothDynamicData* DynamicData = new FVerletClothDynamicData;
+		VerletClothKernels::ComputeGridTangents(Data.Positions.GetData(), Data.NumLines, Data.NumPointsPerLine, (uint32*)Data.Tangents.GetData());
+		return;
+	}
 
-		// Transform current positions from lines into component-space array
-		int32 NumLines = HorizontalLines.Num();
-		DynamicData->HorizontalLines.AddZeroed(NumLines);
-		for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+	// Normals are shared by the vertices of a particle so seams stay smooth
+	const TArray<uint32>& Indices = Topology.RenderIndices;
+	const TArray<FVector2D>& UVs = Topology.RenderUVs;
+	const TArray<int32>& VertexParticles = Topology.RenderParticles;
+	const int32 NumVerts = Data.Positions.Num();
+
+	Data.ParticleNormals.Reset();
+	Data.ParticleNormals.AddZeroed(Topology.NumParticles);
+	Data.VertexTangents.Reset();
+	Data.VertexTangents.AddZeroed(NumVerts * 2);
+
+	// Area weighted sums of the triangle normals, and of the directions of U and V along the triangles
+	for (int32 Idx = 0; Idx + 2 < Indices.Num(); Idx += 3)
+	{
+		const uint32 A = Indices[Idx];
+		const uint32 B = Indices[Idx + 1];
+		const uint32 C = Indices[Idx + 2];
+		const FVector EdgeB = Data.Positions[B] - Data.Positions[A];
+		const FVector EdgeC = Data.Positions[C] - Data.Positions[A];
+		const FVector2D DeltaUVB = UVs[B] - UVs[A];
+		const FVector2D DeltaUVC = UVs[C] - UVs[A];
+
+		const FVector Normal = EdgeC ^ EdgeB;
+		const float Sign = (DeltaUVB.X * DeltaUVC.Y - DeltaUVC.X * DeltaUVB.Y) < 0.0f ? -1.0f : 1.0f;
+		const FVector TangentU = (EdgeB * DeltaUVC.Y - EdgeC * DeltaUVB.Y) * Sign;
+		const FVector TangentV = (EdgeC * DeltaUVB.X - EdgeB * DeltaUVC.X) * Sign;
+		const uint32 Corners[3] = { A, B, C };
+		for (uint32 VertIdx : Corners)
 		{
-			int32 NumPoints = HorizontalLines[LineIdx].Positions.Num();
-			DynamicData->HorizontalLines[LineIdx].Points.AddZeroed(NumPoints);
-			for (int32 PointIdx = 0; PointIdx < NumPoints; ++PointIdx)
-			{
-				DynamicData->HorizontalLines[LineIdx].Points[PointIdx] = ProcessWorldSpace ? ComponentToWorld.InverseTransformPosition(HorizontalLines[LineIdx].Positions[PointIdx])
-					: HorizontalLines[LineIdx].Positions[PointIdx];
-			}			
+			Data.ParticleNormals[VertexParticles[VertIdx]] += Normal;
+			Data.VertexTangents[VertIdx * 2] += TangentU;
+			Data.VertexTangents[VertIdx * 2 + 1] += TangentV;
 		}
+	}
+
+	for (int32 VertIdx = 0; VertIdx < NumVerts; ++VertIdx)
+	{
+		const FVector Normal = Data.ParticleNormals[VertexParticles[VertIdx]].GetSafeNormal();
+		const FVector TangentU = Data.VertexTangents[VertIdx * 2];
+		const FVector TangentX = (TangentU - Normal * (TangentU | Normal)).GetSafeNormal();
+		Data.Tangents[VertIdx].SetTangents(TangentX, Data.VertexTangents[VertIdx * 2 + 1], Normal);
+	}
+}
+
+void UVerletClothComponent::SendRenderDynamicData_Concurrent()
+{
+	if (SceneProxy)
+	{
+		// Tears go with the positions, swapping keeps both allocations around
+		FVerletClothDynamicData* DynamicData = CreateDynamicData();
+		Swap(DynamicData->MeshPatch, PendingMeshPatch);
 
 		// Enqueue command to send to render thread
 		ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
@@ -484,126 +1622,232 @@ void UVerletClothComponent::SendRenderDynamicData_Concurrent()
 
 FPrimitiveSceneProxy* UVerletClothComponent::CreateSceneProxy()
 {
+	if (!DynamicDataPool.IsValid())
+	{
+		DynamicDataPool = MakeShareable(new FVerletClothDynamicDataPool);
+	}
 	return new FVerletClothSceneProxy(this);
 }
 
-FBoxSphereBounds UVerletClothComponent::CalcBounds(const FTransform& LocalToWorld) const
+SIZE_T UVerletClothComponent::GetResourceSize(EResourceSizeMode::Type Mode)
 {
-	// Calculate bounding box of cloth points
-	FBox ClothBox(0);
-	for (int32 LineIdx = 0; LineIdx < HorizontalLines.Num(); LineIdx++)
-	{
-		const FVerletClothHorizontalLine& Line = HorizontalLines[LineIdx];
-		for (int32 PointIdx = 0; PointIdx < Line.Positions.Num(); ++PointIdx)
-			ClothBox += ProcessWorldSpace ? Line.Positions[PointIdx] : ComponentToWorld.TransformPosition(Line.Positions[PointIdx]);
-	}
-
-	return FBoxSphereBounds(ClothBox);
+	return Super::GetResourceSize(Mode) + GetSimulationAllocatedSize();
 }
 
-void UVerletClothComponent::ProcessCollision()
+FBoxSphereBounds UVerletClothComponent::CalcBounds(const FTransform& LocalToWorld) const
 {
-	if (CollisionPlane == ECollisionPlane::NONE)
-		return;
+	// Cloth bounds are computed by the simulation, in world space or component space
+	const FBox& SimulationBox = (BoundsPadding > 0.0f && PaddedBounds.IsValid) ? PaddedBounds : GetRenderedBounds();
+	FBox ClothBox = ProcessWorldSpace ? SimulationBox : SimulationBox.TransformBy(LocalToWorld);
 
-	FVector Origin = ProcessWorldSpace ? ComponentToWorld.GetLocation() : FVector::ZeroVector;
-	FQuat Rotation = ProcessWorldSpace ? ComponentToWorld.GetRotation() : FQuat::Identity;
+	// The rendered mesh is still blending from the previous LOD's shape
+	if (LODBlendAlpha < 1.0f && LODBlendBounds.IsValid)
+		ClothBox += LODBlendBounds.TransformBy(LocalToWorld);
 
-	FPlane Plane;
-	switch (CollisionPlane)
-	{
-	case ECollisionPlane::XY: Plane = FPlane( Origin, Rotation.GetAxisZ() ); break;
-	case ECollisionPlane::YZ: Plane = FPlane( Origin, Rotation.GetAxisX() ); break;
-	case ECollisionPlane::ZX: Plane = FPlane( Origin, Rotation.GetAxisY() ); break;
-	}
+	return FBoxSphereBounds(ClothBox);
+}
 
-	const int32 NumLines = NumSegments + 1;
-	for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+void UVerletClothComponent::GatherColliders(FVerletClothSimulationInput& Input) const
+{
+	USceneComponent* Parent = GetAttachParent();
+	for (const FVerletClothCollisionShape& Shape : CollisionShapes)
 	{
-		FVerletClothHorizontalLine& Line = HorizontalLines[LineIdx];
-		if (Line.bFree)
+		// Shapes follow a socket of the attach parent, or the component
+		const bool bOnSocket = Shape.SocketName != NAME_None && Parent && Parent->DoesSocketExist(Shape.SocketName);
+		const FTransform BaseToWorld = bOnSocket ? Parent->GetSocketTransform(Shape.SocketName) : Input.ComponentToWorld;
+		const FTransform ShapeToWorld = FTransform(Shape.Rotation, Shape.Location) * BaseToWorld;
+		const FTransform ShapeToSimulation = ProcessWorldSpace ? ShapeToWorld : ShapeToWorld.GetRelativeTransform(Input.ComponentToWorld);
+		const FVector Scale = ShapeToSimulation.GetScale3D().GetAbs();
+
+		FVerletClothCollider& Collider = Input.Colliders[Input.Colliders.AddUninitialized()];
+		Collider.bBox = (Shape.Type == EVerletClothShapeType::Box);
+		Collider.Start = ShapeToSimulation.GetLocation();
+		Collider.End = Collider.Start;
+		Collider.Radius = 0.0f;
+		Collider.Rotation = ShapeToSimulation.GetRotation();
+		Collider.Extent = FVector::ZeroVector;
+
+		if (Collider.bBox)
 		{
-			for (int32 PointIdx = 0; PointIdx < Line.Positions.Num(); ++PointIdx)
+			Collider.Extent = Shape.BoxExtent * Scale;
+			Collider.Bounds = FBox(-Collider.Extent, Collider.Extent).TransformBy(FTransform(Collider.Rotation, Collider.Start));
+		}
+		else
+		{
+			Collider.Radius = Shape.Radius * Scale.GetMax();
+			if (Shape.Type == EVerletClothShapeType::Capsule)
 			{
-				float Distance = Plane.PlaneDot( Line.Positions[PointIdx] );
-				if (Distance < 0.0f)
-					Line.Positions[PointIdx] += (FVector( Plane.X, Plane.Y, Plane.Z ) * (-Distance));
+				const FVector HalfSegment = ShapeToSimulation.TransformVector(FVector(0.0f, 0.0f, Shape.HalfLength));
+				Collider.Start -= HalfSegment;
+				Collider.End += HalfSegment;
 			}
+			Collider.Bounds = FBox(Collider.Start.ComponentMin(Collider.End), Collider.Start.ComponentMax(Collider.End)).ExpandBy(Collider.Radius);
 		}
 	}
 }
 
-void UVerletClothComponent::SolveConstraints()
+FVerletClothSimulationSettings UVerletClothComponent::GetSimulationSettings() const
 {
-	const float SegmentLength = ClothLength / (float)NumSegments;
-	const float HorizontalLength = ClothWidth / (float)NumSides;
-	const float DiagonalLength = FMath::Sqrt(SegmentLength*SegmentLength + HorizontalLength*HorizontalLength);
+	FVerletClothSimulationSettings Settings;
+	Settings.Damping = Damping;
+	Settings.SolverIterations = SolverIterations;
+	Settings.SolverTolerance = SolverTolerance;
+	Settings.SolverRelaxation = SolverRelaxation;
+	Settings.bParallelSolver = bParallelSolver;
+	Settings.ParallelBatchSize = Align(FMath::Max(CVarVerletClothParallelBatchSize.GetValueOnGameThread(), 1), FVerletClothParticles::StreamAlignment);
+	Settings.bUseXPBD = bUseXPBD;
+	Settings.Compliance[FVerletClothTopology::Structural] = StretchCompliance;
+	Settings.Compliance[FVerletClothTopology::Shear] = ShearCompliance;
+	Settings.Compliance[FVerletClothTopology::Bend] = BendCompliance;
+	Settings.WindDrag = WindDrag;
+	Settings.WindLift = WindLift;
+	Settings.SelfCollisionThickness = bSelfCollision ? SelfCollisionThickness : 0.0f;
+	return Settings;
+}
 
-	// For each iteration..
-	for (int32 IterationIdx = 0; IterationIdx < SolverIterations; IterationIdx++)
-	{
-		// For each segment..
-		for (int32 SegIdx = 0; SegIdx < NumSegments; SegIdx++)
-		{
-			FVerletClothHorizontalLine& LineA = HorizontalLines[SegIdx];
-			FVerletClothHorizontalLine& LineB = HorizontalLines[SegIdx + 1];
-			LineA.SolveConstraints(LineB, SegmentLength, DiagonalLength);
-		}
+void UVerletClothComponent::GetSnapshotParams(FVerletClothSnapshotParams& OutParams) const
+{
+	const FVerletClothLODSettings* LOD = (CurrentLOD > 0 && CurrentLOD <= LODs.Num()) ? &LODs[CurrentLOD - 1] : NULL;
+	OutParams.SubstepTime = 1.0f / FMath::Max(LOD ? LOD->SubstepRate : 60.0f, 1.0f);
+	OutParams.Settings = GetSimulationSettings();
+	OutParams.TetherScale = bLongRangeTethers ? TetherScale : 0.0f;
+
+	// Gravity and wind as the next simulation would see them
+	UWorld* World = GetWorld();
+	const float WorldGravityZ = (World && World->GetWorldSettings()) ? World->GetWorldSettings()->GetGravityZ() : 0.0f;
+	const FVerletClothSimulationInput Input = GatherSimulationInput(0.0f, 1.0f, WorldGravityZ);
+	OutParams.Gravity = Input.Gravity;
+	OutParams.Wind = Input.Wind;
+}
 
-		//  θ 
-		HorizontalLines[NumSegments].SolveHorizontalConstraint();
-	}
+uint32 UVerletClothComponent::GetSimulationAllocatedSize() const
+{
+	uint32 Size = Particles.GetAllocatedSize() + Topology.GetAllocatedSize() + Tethers.GetAllocatedSize()
+		+ ConstraintBatches.GetAllocatedSize() + ConstraintBatchTypes.GetAllocatedSize()
+		+ PinnedPositions.GetAllocatedSize() + WindPositions.GetAllocatedSize() + LODBlendPositions.GetAllocatedSize()
+		+ AsyncPositions[0].GetAllocatedSize() + AsyncPositions[1].GetAllocatedSize();
+	for (const FVerletClothConstraintBatch& Batch : ConstraintBatches)
+		Size += Batch.GetAllocatedSize();
+	if (Solver.IsValid())
+		Size += Solver->GetAllocatedSize();
+	return Size;
 }
 
-void UVerletClothComponent::UpdateAcceleration(const FVector& Gravity, const FVector& WindVec)
+void UVerletClothComponent::UpdateSimulationMemoryStat()
 {
-	// For each segment..
-	for (int32 SegIdx = 0; SegIdx < NumSegments; SegIdx++)
+#if STATS
+	const uint32 Size = GetSimulationAllocatedSize();
+	if (Size != ReportedSimulationMemory)
 	{
-		FVerletClothHorizontalLine& LineA = HorizontalLines[SegIdx];
-		FVerletClothHorizontalLine& LineB = HorizontalLines[SegIdx + 1];
-		if (LineA.bFree)
-			LineA.UpdateAcceleration(LineB, Gravity, WindVec, (SegIdx == NumSegments - 1));
+		DEC_MEMORY_STAT_BY(STAT_VerletCloth_SimulationMemory, ReportedSimulationMemory);
+		INC_MEMORY_STAT_BY(STAT_VerletCloth_SimulationMemory, Size);
+		ReportedSimulationMemory = Size;
 	}
+#endif
 }
 
-void UVerletClothComponent::VerletIntegrate(float InTime)
+void UVerletClothComponent::BuildTopology()
 {
-	FVector SideAxisVector;
-	switch (SideAxis)
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_BuildTopology);
+
+	// Mesh topologies are built on register, their rest lengths never change.
+	// Tearable grids are rendered from their topology, the proxy's grid cannot follow tears.
+	if (Topology.bGrid)
 	{
-	case ESideAxis::X: SideAxisVector = ProcessWorldSpace ? ComponentToWorld.TransformVector(FVector::ForwardVector) : FVector::ForwardVector; break;
-	case ESideAxis::Y: SideAxisVector = ProcessWorldSpace ? ComponentToWorld.TransformVector(FVector::RightVector) : FVector::RightVector; break;
-	default: SideAxisVector = ProcessWorldSpace ? ComponentToWorld.TransformVector(FVector::UpVector) : FVector::UpVector; break;
+		Topology.BuildGrid(Particles.NumLines, Particles.NumPointsPerLine, SimulatedFixedLineCount, ClothLength, ClothWidth, bTearable);
+		BatchedClothLength = ClothLength;
+		BatchedClothWidth = ClothWidth;
 	}
 
-	FVector CompLocation = GetComponentLocation();
-	FVector CenterLocation = ProcessWorldSpace ? CompLocation : ComponentToWorld.InverseTransformVector(CompLocation - OldComponentLocation);
-	OldComponentLocation = CompLocation;
+	// Tears found or made before refer to the previous topology
+	Topology.SetTearBudget(bTearable ? MaxTornParticles : 0);
+	PendingTears.Reset();
+	PendingMeshPatch.Reset();
 
-	const int32 NumLines = NumSegments + 1;
-	const float TimeSqr = InTime * InTime;
-	FVector GravityVec = FVector::ZeroVector;
-	if (bUseLocalGravity)
-	{
-		GravityVec = ProcessWorldSpace ? ComponentToWorld.TransformVector(Gravity) : Gravity;		
-	}
+	BuildSolverBatches();
+}
+
+void UVerletClothComponent::BuildSolverBatches()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_BuildSolverBatches);
+
+	Topology.BuildBatches(ConstraintBatches, ConstraintBatchTypes, Particles.GetNullIndex());
+
+	if (bLongRangeTethers)
+		Topology.BuildTethers(Tethers, TetherScale, Particles.GetNullIndex());
 	else
+		Tethers = FVerletClothConstraintBatch();
+}
+
+void UVerletClothComponent::FindTears(float StretchRatio)
+{
+	PendingTears.Reset();
+	if (!Topology.HasRenderMesh() || Topology.NumParticles >= Topology.MaxParticles)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_Tearing);
+
+	// Structural constraints are sorted first
+	const float MaxStretchSquared = FMath::Square(FMath::Max(StretchRatio, 1.0f));
+	const FVerletClothConstraintBatch& Constraints = Topology.Constraints;
+	for (int32 ConstraintIdx = 0; ConstraintIdx < Constraints.Num() && Topology.ConstraintTypes[ConstraintIdx] == FVerletClothTopology::Structural; ++ConstraintIdx)
 	{
-		check(GetWorld()->GetWorldSettings());
-		FVector WorldGravity = FVector(0.0f, 0.0f, GetWorld()->GetWorldSettings()->GetGravityZ());
-		GravityVec = ProcessWorldSpace ? WorldGravity : ComponentToWorld.InverseTransformVector(WorldGravity);
+		const float RestLength = Constraints.RestLength[ConstraintIdx];
+		const float LengthSquared = FVector::DistSquared(Particles.GetPosition(Constraints.IndexA[ConstraintIdx]), Particles.GetPosition(Constraints.IndexB[ConstraintIdx]));
+		if (LengthSquared > RestLength * RestLength * MaxStretchSquared)
+			PendingTears.Add(ConstraintIdx);
 	}
+}
 
-	FVector WindVec = ProcessWorldSpace ? ComponentToWorld.TransformVector(Wind) : Wind;
-	UpdateAcceleration(GravityVec, WindVec);
+void UVerletClothComponent::ApplyTears()
+{
+	if (PendingTears.Num() == 0)
+		return;
 
-	for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_Tearing);
+
+	// A particle is torn once per frame, the constraints of its new particle are checked again next frame
+	const int32 OldNumParticles = Topology.NumParticles;
+	TArray<int32, TInlineAllocator<16>> TornParticles;
+	for (int32 ConstraintIdx : PendingTears)
 	{
-		FVerletClothHorizontalLine& Line = HorizontalLines[LineIdx];
-		if (Line.bFree)
-			Line.VerletProcess(TimeSqr);
-		else
-			Line.FixedProcess(CenterLocation, SideAxisVector);
+		const int32 IdxA = Topology.Constraints.IndexA[ConstraintIdx];
+		const int32 IdxB = Topology.Constraints.IndexB[ConstraintIdx];
+		if (IdxA >= OldNumParticles || IdxB >= OldNumParticles || TornParticles.Contains(IdxA) || TornParticles.Contains(IdxB))
+			continue;
+
+		// The cloth opens across the stretched constraint, at whichever end can be torn
+		const FVector Direction = (Particles.GetPosition(IdxB) - Particles.GetPosition(IdxA)).GetSafeNormal();
+		int32 TornIdx = IdxA;
+		int32 NewIdx = Topology.SplitParticle(IdxA, Direction, Particles, PendingMeshPatch);
+		if (NewIdx == INDEX_NONE)
+		{
+			TornIdx = IdxB;
+			NewIdx = Topology.SplitParticle(IdxB, -Direction, Particles, PendingMeshPatch);
+		}
+		if (NewIdx == INDEX_NONE)
+			continue;
+
+		check(NewIdx == Particles.NumParticles);
+		Particles.AddParticles(1);
+		Particles.SetPosition(NewIdx, Particles.GetPosition(TornIdx));
+		Particles.SetSavedPosition(NewIdx, Particles.GetSavedPosition(TornIdx));
+		Particles.SetFree(NewIdx, true);
+		for (TArray<FVector>& Positions : AsyncPositions)
+		{
+			if (Positions.Num() > 0)
+			{
+				const FVector Position = Positions[TornIdx];
+				Positions.Add(Position);
+			}
+		}
+		TornParticles.Add(TornIdx);
 	}
+	PendingTears.Reset();
+
+	if (TornParticles.Num() == 0)
+		return;
+
+	Topology.Finish();
+	BuildSolverBatches();
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 // Copyright 2016 Moai Games, Inc. All Rights Reserved.
 
 #include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothSimulationManager.h"
+#include "VerletClothStats.h"
 
 
 
@@ -14,17 +16,49 @@ class FVerletClothComponentPlugin : public IModuleInterface
 
 IMPLEMENT_MODULE(FVerletClothComponentPlugin, VerletClothComponent )
 
+DEFINE_LOG_CATEGORY(LogVerletCloth);
+
+DEFINE_STAT(STAT_VerletCloth_ManagerTick);
+DEFINE_STAT(STAT_VerletCloth_GatherInput);
+DEFINE_STAT(STAT_VerletCloth_UpdateLOD);
+DEFINE_STAT(STAT_VerletCloth_Tearing);
+DEFINE_STAT(STAT_VerletCloth_BuildTopology);
+DEFINE_STAT(STAT_VerletCloth_BuildSolverBatches);
+DEFINE_STAT(STAT_VerletCloth_AsyncTask);
+DEFINE_STAT(STAT_VerletCloth_Simulate);
+DEFINE_STAT(STAT_VerletCloth_Integrate);
+DEFINE_STAT(STAT_VerletCloth_Forces);
+DEFINE_STAT(STAT_VerletCloth_SolveConstraints);
+DEFINE_STAT(STAT_VerletCloth_SolveTethers);
+DEFINE_STAT(STAT_VerletCloth_SelfCollision);
+DEFINE_STAT(STAT_VerletCloth_Collision);
+DEFINE_STAT(STAT_VerletCloth_PackDynamicData);
+DEFINE_STAT(STAT_VerletCloth_BuildTangents);
+DEFINE_STAT(STAT_VerletCloth_BuildStaticMesh);
+DEFINE_STAT(STAT_VerletCloth_Upload);
+DEFINE_STAT(STAT_VerletCloth_GetDynamicMeshElements);
+DEFINE_STAT(STAT_VerletCloth_SimulatedComponents);
+DEFINE_STAT(STAT_VerletCloth_SleepingComponents);
+DEFINE_STAT(STAT_VerletCloth_ThrottledComponents);
+DEFINE_STAT(STAT_VerletCloth_Particles);
+DEFINE_STAT(STAT_VerletCloth_Constraints);
+DEFINE_STAT(STAT_VerletCloth_Substeps);
+DEFINE_STAT(STAT_VerletCloth_SolverIterations);
+DEFINE_STAT(STAT_VerletCloth_BytesUploaded);
+DEFINE_STAT(STAT_VerletCloth_SimulationMemory);
+DEFINE_STAT(STAT_VerletCloth_ProxyMemory);
+
 
 
 void FVerletClothComponentPlugin::StartupModule()
 {
-	
+	FVerletClothSimulationManager::OnStartup();
 }
 
 
 void FVerletClothComponentPlugin::ShutdownModule()
 {
-	
+	FVerletClothSimulationManager::OnShutdown();
 }
 
 
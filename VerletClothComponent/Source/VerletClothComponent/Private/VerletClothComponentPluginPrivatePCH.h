@@ -1,3 +1,11 @@
+#if VERLETCLOTH_STANDALONE
+
+// Simulation core built without the engine, see VerletClothCore/CMakeLists.txt
+#include "VerletClothStandalone.h"
+#include "VerletClothCore.h"
+
+#else
+
 #include "CoreUObject.h"
 #include "Engine.h"
 
@@ -5,4 +13,8 @@
 // add includes for headers that are used in most of your module's source files though.
 #include "ModuleManager.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogVerletCloth, Log, All);
+
 #include "VerletClothComponent.h"
+
+#endif
@@ -0,0 +1,713 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothKernels.h"
+#include "VerletClothSimd.h"
+#include "ParallelFor.h"
+
+using namespace VerletClothSimd;
+
+/** Grid lines whose tangents are built by one task */
+static const int32 TangentLinesPerTask = 16;
+
+static TAutoConsoleVariable<int32> CVarVerletClothSimd(
+	TEXT("verletcloth.Simd"),
+	1,
+	TEXT("Use the vectorized cloth kernels. 0 forces the scalar path."),
+	ECVF_Default);
+
+namespace
+{
+	template<typename VecType>
+	void SetAccelerationImpl(FVerletClothParticles& Particles, const FVector& Acceleration)
+	{
+		float* AccX = Particles.GetStream(FVerletClothParticles::AccelerationX);
+		float* AccY = Particles.GetStream(FVerletClothParticles::AccelerationY);
+		float* AccZ = Particles.GetStream(FVerletClothParticles::AccelerationZ);
+
+		const VecType X = VecType::Splat(Acceleration.X);
+		const VecType Y = VecType::Splat(Acceleration.Y);
+		const VecType Z = VecType::Splat(Acceleration.Z);
+		for (int32 Idx = 0; Idx < Particles.StreamStride; Idx += VecType::Width)
+		{
+			X.Store(AccX + Idx);
+			Y.Store(AccY + Idx);
+			Z.Store(AccZ + Idx);
+		}
+	}
+
+	template<typename VecType>
+	void IntegrateImpl(FVerletClothParticles& Particles, float DampingFactor, float TimeSqr, FVector& OutMin, FVector& OutMax, float& OutMaxSquaredStep)
+	{
+		float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+		float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+		float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+		float* SavedX = Particles.GetStream(FVerletClothParticles::SavedPositionX);
+		float* SavedY = Particles.GetStream(FVerletClothParticles::SavedPositionY);
+		float* SavedZ = Particles.GetStream(FVerletClothParticles::SavedPositionZ);
+		const float* AccX = Particles.GetStream(FVerletClothParticles::AccelerationX);
+		const float* AccY = Particles.GetStream(FVerletClothParticles::AccelerationY);
+		const float* AccZ = Particles.GetStream(FVerletClothParticles::AccelerationZ);
+		const float* Free = Particles.GetStream(FVerletClothParticles::FreeMask);
+
+		const VecType Damp = VecType::Splat(DampingFactor);
+		const VecType Time = VecType::Splat(TimeSqr);
+		const VecType One = VecType::Splat(1.0f);
+		const VecType Far = VecType::Splat(1.0e30f);
+		VecType MinX = Far, MinY = Far, MinZ = Far;
+		VecType MaxX = Far * VecType::Splat(-1.0f), MaxY = MaxX, MaxZ = MaxX;
+		VecType MaxStep = VecType::Splat(0.0f);
+		for (int32 Idx = 0; Idx < Particles.StreamStride; Idx += VecType::Width)
+		{
+			// Free mask is exactly 0 or 1, pinned particles get a zero step and keep their relative saved position
+			const VecType Mask = VecType::Load(Free + Idx);
+			const VecType X = VecType::Load(PosX + Idx);
+			const VecType Y = VecType::Load(PosY + Idx);
+			const VecType Z = VecType::Load(PosZ + Idx);
+			const VecType OldX = VecType::Load(SavedX + Idx);
+			const VecType OldY = VecType::Load(SavedY + Idx);
+			const VecType OldZ = VecType::Load(SavedZ + Idx);
+
+			const VecType StepX = Mask * ((X - OldX) * Damp + Time * VecType::Load(AccX + Idx));
+			const VecType StepY = Mask * ((Y - OldY) * Damp + Time * VecType::Load(AccY + Idx));
+			const VecType StepZ = Mask * ((Z - OldZ) * Damp + Time * VecType::Load(AccZ + Idx));
+			const VecType NewX = X + StepX;
+			const VecType NewY = Y + StepY;
+			const VecType NewZ = Z + StepZ;
+			NewX.Store(PosX + Idx);
+			NewY.Store(PosY + Idx);
+			NewZ.Store(PosZ + Idx);
+			(OldX + Mask * (X - OldX)).Store(SavedX + Idx);
+			(OldY + Mask * (Y - OldY)).Store(SavedY + Idx);
+			(OldZ + Mask * (Z - OldZ)).Store(SavedZ + Idx);
+
+			// Bounds of the free particles only, pinned and padding ones are pushed out of the way
+			const VecType Pinned = (One - Mask) * Far;
+			MinX = Min(MinX, NewX + Pinned); MinY = Min(MinY, NewY + Pinned); MinZ = Min(MinZ, NewZ + Pinned);
+			MaxX = Max(MaxX, NewX - Pinned); MaxY = Max(MaxY, NewY - Pinned); MaxZ = Max(MaxZ, NewZ - Pinned);
+			MaxStep = Max(MaxStep, StepX * StepX + StepY * StepY + StepZ * StepZ);
+		}
+
+		OutMin = FVector(MinX.ReduceMin(), MinY.ReduceMin(), MinZ.ReduceMin());
+		OutMax = FVector(MaxX.ReduceMax(), MaxY.ReduceMax(), MaxZ.ReduceMax());
+		OutMaxSquaredStep = MaxStep.ReduceMax();
+	}
+
+	template<typename VecType>
+	int32 ProcessPinnedLineImpl(FVerletClothParticles& Particles, int32 LineIdx, const FVector& Start, const FVector& Delta)
+	{
+		// Lines are not aligned, so this walks them unaligned and leaves the remainder to the caller
+		const int32 First = Particles.GetIndex(LineIdx, 0);
+		float* PosX = Particles.GetStream(FVerletClothParticles::PositionX) + First;
+		float* PosY = Particles.GetStream(FVerletClothParticles::PositionY) + First;
+		float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ) + First;
+		const float* SavedX = Particles.GetStream(FVerletClothParticles::SavedPositionX) + First;
+		const float* SavedY = Particles.GetStream(FVerletClothParticles::SavedPositionY) + First;
+		const float* SavedZ = Particles.GetStream(FVerletClothParticles::SavedPositionZ) + First;
+
+		const VecType StartX = VecType::Splat(Start.X);
+		const VecType StartY = VecType::Splat(Start.Y);
+		const VecType StartZ = VecType::Splat(Start.Z);
+		const VecType DeltaX = VecType::Splat(Delta.X);
+		const VecType DeltaY = VecType::Splat(Delta.Y);
+		const VecType DeltaZ = VecType::Splat(Delta.Z);
+
+		int32 PointIdx = 0;
+		for (; PointIdx + VecType::Width <= Particles.NumPointsPerLine; PointIdx += VecType::Width)
+		{
+			const VecType Ramp = VecType::Ramp((float)PointIdx);
+			(StartX + DeltaX * Ramp + VecType::LoadUnaligned(SavedX + PointIdx)).StoreUnaligned(PosX + PointIdx);
+			(StartY + DeltaY * Ramp + VecType::LoadUnaligned(SavedY + PointIdx)).StoreUnaligned(PosY + PointIdx);
+			(StartZ + DeltaZ * Ramp + VecType::LoadUnaligned(SavedZ + PointIdx)).StoreUnaligned(PosZ + PointIdx);
+		}
+		return PointIdx;
+	}
+
+	template<typename VecType>
+	float GetMaxSquaredStepImpl(const FVerletClothParticles& Particles)
+	{
+		const float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+		const float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+		const float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+		const float* SavedX = Particles.GetStream(FVerletClothParticles::SavedPositionX);
+		const float* SavedY = Particles.GetStream(FVerletClothParticles::SavedPositionY);
+		const float* SavedZ = Particles.GetStream(FVerletClothParticles::SavedPositionZ);
+		const float* Free = Particles.GetStream(FVerletClothParticles::FreeMask);
+
+		VecType MaxStep = VecType::Splat(0.0f);
+		for (int32 Idx = 0; Idx < Particles.StreamStride; Idx += VecType::Width)
+		{
+			// Saved position of pinned particles is an offset, the mask zeroes them
+			const VecType DeltaX = VecType::Load(PosX + Idx) - VecType::Load(SavedX + Idx);
+			const VecType DeltaY = VecType::Load(PosY + Idx) - VecType::Load(SavedY + Idx);
+			const VecType DeltaZ = VecType::Load(PosZ + Idx) - VecType::Load(SavedZ + Idx);
+			MaxStep = Max(MaxStep, (DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ) * VecType::Load(Free + Idx));
+		}
+		return MaxStep.ReduceMax();
+	}
+
+	template<typename VecType>
+	void ComputeBoundsImpl(const FVerletClothParticles& Particles, bool bIncludeSaved, int32 Begin, int32 End, FVector& InOutMin, FVector& InOutMax)
+	{
+		const float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+		const float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+		const float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+		const float* SavedX = Particles.GetStream(FVerletClothParticles::SavedPositionX);
+		const float* SavedY = Particles.GetStream(FVerletClothParticles::SavedPositionY);
+		const float* SavedZ = Particles.GetStream(FVerletClothParticles::SavedPositionZ);
+		const float* Free = Particles.GetStream(FVerletClothParticles::FreeMask);
+
+		VecType MinX = VecType::Splat(InOutMin.X), MinY = VecType::Splat(InOutMin.Y), MinZ = VecType::Splat(InOutMin.Z);
+		VecType MaxX = VecType::Splat(InOutMax.X), MaxY = VecType::Splat(InOutMax.Y), MaxZ = VecType::Splat(InOutMax.Z);
+		for (int32 Idx = Begin; Idx < End; Idx += VecType::Width)
+		{
+			const VecType X = VecType::Load(PosX + Idx);
+			const VecType Y = VecType::Load(PosY + Idx);
+			const VecType Z = VecType::Load(PosZ + Idx);
+			MinX = Min(MinX, X); MinY = Min(MinY, Y); MinZ = Min(MinZ, Z);
+			MaxX = Max(MaxX, X); MaxY = Max(MaxY, Y); MaxZ = Max(MaxZ, Z);
+
+			if (bIncludeSaved)
+			{
+				// Saved position of pinned particles is an offset, the mask puts them back on their position
+				const VecType Mask = VecType::Load(Free + Idx);
+				const VecType OldX = X + Mask * (VecType::Load(SavedX + Idx) - X);
+				const VecType OldY = Y + Mask * (VecType::Load(SavedY + Idx) - Y);
+				const VecType OldZ = Z + Mask * (VecType::Load(SavedZ + Idx) - Z);
+				MinX = Min(MinX, OldX); MinY = Min(MinY, OldY); MinZ = Min(MinZ, OldZ);
+				MaxX = Max(MaxX, OldX); MaxY = Max(MaxY, OldY); MaxZ = Max(MaxZ, OldZ);
+			}
+		}
+
+		InOutMin = FVector(MinX.ReduceMin(), MinY.ReduceMin(), MinZ.ReduceMin());
+		InOutMax = FVector(MaxX.ReduceMax(), MaxY.ReduceMax(), MaxZ.ReduceMax());
+	}
+
+	template<typename VecType>
+	void ProjectPlaneImpl(FVerletClothParticles& Particles, const FPlane& Plane)
+	{
+		float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+		float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+		float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+		const float* Free = Particles.GetStream(FVerletClothParticles::FreeMask);
+
+		const VecType NormalX = VecType::Splat(Plane.X);
+		const VecType NormalY = VecType::Splat(Plane.Y);
+		const VecType NormalZ = VecType::Splat(Plane.Z);
+		const VecType PlaneW = VecType::Splat(Plane.W);
+		const VecType Zero = VecType::Splat(0.0f);
+		for (int32 Idx = 0; Idx < Particles.StreamStride; Idx += VecType::Width)
+		{
+			const VecType X = VecType::Load(PosX + Idx);
+			const VecType Y = VecType::Load(PosY + Idx);
+			const VecType Z = VecType::Load(PosZ + Idx);
+
+			// Only the penetration (negative distance) of free particles is corrected
+			const VecType Distance = NormalX * X + NormalY * Y + NormalZ * Z - PlaneW;
+			const VecType Penetration = Min(Distance, Zero) * VecType::Load(Free + Idx);
+
+			(X - NormalX * Penetration).Store(PosX + Idx);
+			(Y - NormalY * Penetration).Store(PosY + Idx);
+			(Z - NormalZ * Penetration).Store(PosZ + Idx);
+		}
+	}
+
+	template<typename VecType>
+	void CollideCapsuleImpl(FVerletClothParticles& Particles, const FVector& Start, const FVector& End, float Radius)
+	{
+		float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+		float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+		float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+		const float* Free = Particles.GetStream(FVerletClothParticles::FreeMask);
+
+		const FVector Segment = End - Start;
+		const VecType StartX = VecType::Splat(Start.X);
+		const VecType StartY = VecType::Splat(Start.Y);
+		const VecType StartZ = VecType::Splat(Start.Z);
+		const VecType SegmentX = VecType::Splat(Segment.X);
+		const VecType SegmentY = VecType::Splat(Segment.Y);
+		const VecType SegmentZ = VecType::Splat(Segment.Z);
+		const VecType InvSegmentSizeSquared = VecType::Splat(1.0f / FMath::Max(Segment.SizeSquared(), SMALL_NUMBER));
+		const VecType RadiusV = VecType::Splat(Radius);
+		const VecType Zero = VecType::Splat(0.0f);
+		const VecType One = VecType::Splat(1.0f);
+		const VecType Small = VecType::Splat(SMALL_NUMBER);
+		for (int32 Idx = 0; Idx < Particles.StreamStride; Idx += VecType::Width)
+		{
+			const VecType X = VecType::Load(PosX + Idx);
+			const VecType Y = VecType::Load(PosY + Idx);
+			const VecType Z = VecType::Load(PosZ + Idx);
+
+			// Closest point of the segment
+			const VecType T = Min(Max((SegmentX * (X - StartX) + SegmentY * (Y - StartY) + SegmentZ * (Z - StartZ)) * InvSegmentSizeSquared, Zero), One);
+			const VecType ClosestX = StartX + SegmentX * T;
+			const VecType ClosestY = StartY + SegmentY * T;
+			const VecType ClosestZ = StartZ + SegmentZ * T;
+
+			// Free particles closer than the radius move out to it, away from the segment
+			const VecType DeltaX = X - ClosestX;
+			const VecType DeltaY = Y - ClosestY;
+			const VecType DeltaZ = Z - ClosestZ;
+			const VecType DistanceSquared = DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ;
+			const VecType Inside = CompareLess(DistanceSquared, RadiusV * RadiusV) * VecType::Load(Free + Idx);
+			const VecType Push = Inside * (RadiusV / Max(Sqrt(DistanceSquared), Small) - One);
+
+			(X + DeltaX * Push).Store(PosX + Idx);
+			(Y + DeltaY * Push).Store(PosY + Idx);
+			(Z + DeltaZ * Push).Store(PosZ + Idx);
+		}
+	}
+
+	template<typename VecType>
+	void CollideBoxImpl(FVerletClothParticles& Particles, const FVector& Center, const FQuat& Rotation, const FVector& Extent)
+	{
+		float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+		float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+		float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+		const float* Free = Particles.GetStream(FVerletClothParticles::FreeMask);
+
+		const FVector Axes[3] = { Rotation.GetAxisX(), Rotation.GetAxisY(), Rotation.GetAxisZ() };
+		VecType AxisX[3], AxisY[3], AxisZ[3], ExtentV[3];
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			AxisX[Axis] = VecType::Splat(Axes[Axis].X);
+			AxisY[Axis] = VecType::Splat(Axes[Axis].Y);
+			AxisZ[Axis] = VecType::Splat(Axes[Axis].Z);
+			ExtentV[Axis] = VecType::Splat(Extent[Axis]);
+		}
+		const VecType CenterX = VecType::Splat(Center.X);
+		const VecType CenterY = VecType::Splat(Center.Y);
+		const VecType CenterZ = VecType::Splat(Center.Z);
+		const VecType Zero = VecType::Splat(0.0f);
+		const VecType One = VecType::Splat(1.0f);
+		const VecType Two = VecType::Splat(2.0f);
+		for (int32 Idx = 0; Idx < Particles.StreamStride; Idx += VecType::Width)
+		{
+			const VecType X = VecType::Load(PosX + Idx);
+			const VecType Y = VecType::Load(PosY + Idx);
+			const VecType Z = VecType::Load(PosZ + Idx);
+			const VecType DeltaX = X - CenterX;
+			const VecType DeltaY = Y - CenterY;
+			const VecType DeltaZ = Z - CenterZ;
+
+			// Box space coordinates and depth below each pair of faces
+			VecType Local[3], Depth[3];
+			VecType Inside = VecType::Load(Free + Idx);
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				Local[Axis] = AxisX[Axis] * DeltaX + AxisY[Axis] * DeltaY + AxisZ[Axis] * DeltaZ;
+				Depth[Axis] = ExtentV[Axis] - Abs(Local[Axis]);
+				Inside = Inside * CompareLess(Zero, Depth[Axis]);
+			}
+
+			// Exit through the shallowest face, toward the side the particle is on
+			const VecType UseX = (One - CompareLess(Depth[1], Depth[0])) * (One - CompareLess(Depth[2], Depth[0]));
+			const VecType UseY = (One - UseX) * (One - CompareLess(Depth[2], Depth[1]));
+			const VecType UseZ = One - UseX - UseY;
+			const VecType Use[3] = { UseX, UseY, UseZ };
+
+			VecType OffsetX = Zero, OffsetY = Zero, OffsetZ = Zero;
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				const VecType Sign = One - Two * CompareLess(Local[Axis], Zero);
+				const VecType Distance = Inside * Use[Axis] * Sign * Depth[Axis];
+				OffsetX = OffsetX + AxisX[Axis] * Distance;
+				OffsetY = OffsetY + AxisY[Axis] * Distance;
+				OffsetZ = OffsetZ + AxisZ[Axis] * Distance;
+			}
+
+			(X + OffsetX).Store(PosX + Idx);
+			(Y + OffsetY).Store(PosY + Idx);
+			(Z + OffsetZ).Store(PosZ + Idx);
+		}
+	}
+
+	template<typename VecType>
+	VerletClothKernels::FResidual SolveDistanceConstraintsImpl(FVerletClothParticles& Particles, const int32* IndexA, const int32* IndexB, const float* RestLength, int32 Num, float Relaxation)
+	{
+		float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+		float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+		float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+		const float* Free = Particles.GetStream(FVerletClothParticles::FreeMask);
+
+		const VecType Zero = VecType::Splat(0.0f);
+		const VecType Small = VecType::Splat(SMALL_NUMBER);
+		const VecType RelaxationV = VecType::Splat(Relaxation);
+		VecType MaxCorrection = Zero;
+		VecType SumSquaredCorrection = Zero;
+		for (int32 Idx = 0; Idx < Num; Idx += VecType::Width)
+		{
+			const int32* A = IndexA + Idx;
+			const int32* B = IndexB + Idx;
+			const VecType AX = Gather<VecType>(PosX, A);
+			const VecType AY = Gather<VecType>(PosY, A);
+			const VecType AZ = Gather<VecType>(PosZ, A);
+			const VecType DeltaX = Gather<VecType>(PosX, B) - AX;
+			const VecType DeltaY = Gather<VecType>(PosY, B) - AY;
+			const VecType DeltaZ = Gather<VecType>(PosZ, B) - AZ;
+
+			// Constraints only resist stretching, degenerate ones end up with a negative error and are skipped as well
+			const VecType Distance = Sqrt(DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ);
+			const VecType ErrorFactor = Max((Distance - VecType::LoadUnaligned(RestLength + Idx)) / Max(Distance, Small), Zero) * RelaxationV;
+
+			// Split the correction between free particles, pinned ones have a zero weight
+			const VecType FreeA = Gather<VecType>(Free, A);
+			const VecType FreeB = Gather<VecType>(Free, B);
+			const VecType Scale = ErrorFactor / Max(FreeA + FreeB, Small);
+			const VecType FactorA = Scale * FreeA;
+			const VecType FactorB = Scale * FreeB;
+
+			const VecType Correction = (FactorA + FactorB) * Distance;
+			MaxCorrection = Max(MaxCorrection, Correction);
+			SumSquaredCorrection = SumSquaredCorrection + Correction * Correction;
+
+			Scatter(AX + FactorA * DeltaX, PosX, A);
+			Scatter(AY + FactorA * DeltaY, PosY, A);
+			Scatter(AZ + FactorA * DeltaZ, PosZ, A);
+			Scatter(AX + DeltaX - FactorB * DeltaX, PosX, B);
+			Scatter(AY + DeltaY - FactorB * DeltaY, PosY, B);
+			Scatter(AZ + DeltaZ - FactorB * DeltaZ, PosZ, B);
+		}
+
+		VerletClothKernels::FResidual Residual;
+		Residual.MaxCorrection = MaxCorrection.ReduceMax();
+		Residual.SumSquaredCorrection = SumSquaredCorrection.ReduceAdd();
+		return Residual;
+	}
+
+	template<typename VecType>
+	VerletClothKernels::FResidual SolveCompliantDistanceConstraintsImpl(FVerletClothParticles& Particles, const int32* IndexA, const int32* IndexB, const float* RestLength, float* Lambda, float Alpha, int32 Num, float Relaxation)
+	{
+		float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+		float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+		float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+		const float* Free = Particles.GetStream(FVerletClothParticles::FreeMask);
+
+		const VecType Zero = VecType::Splat(0.0f);
+		const VecType Small = VecType::Splat(SMALL_NUMBER);
+		const VecType AlphaV = VecType::Splat(Alpha);
+		const VecType RelaxationV = VecType::Splat(Relaxation);
+		VecType MaxCorrection = Zero;
+		VecType SumSquaredCorrection = Zero;
+		for (int32 Idx = 0; Idx < Num; Idx += VecType::Width)
+		{
+			const int32* A = IndexA + Idx;
+			const int32* B = IndexB + Idx;
+			const VecType AX = Gather<VecType>(PosX, A);
+			const VecType AY = Gather<VecType>(PosY, A);
+			const VecType AZ = Gather<VecType>(PosZ, A);
+			const VecType DeltaX = Gather<VecType>(PosX, B) - AX;
+			const VecType DeltaY = Gather<VecType>(PosY, B) - AY;
+			const VecType DeltaZ = Gather<VecType>(PosZ, B) - AZ;
+			const VecType Distance = Sqrt(DeltaX * DeltaX + DeltaY * DeltaY + DeltaZ * DeltaZ);
+
+			// The multiplier is clamped so constraints never push, padding and degenerate constraints keep a zero one
+			const VecType FreeA = Gather<VecType>(Free, A);
+			const VecType FreeB = Gather<VecType>(Free, B);
+			const VecType OldLambda = VecType::LoadUnaligned(Lambda + Idx);
+			const VecType Error = Distance - VecType::LoadUnaligned(RestLength + Idx) + AlphaV * OldLambda;
+			const VecType NewLambda = Min(OldLambda - Error / Max(FreeA + FreeB + AlphaV, Small) * RelaxationV, Zero) * CompareLess(Small, Distance);
+			NewLambda.StoreUnaligned(Lambda + Idx);
+
+			const VecType Scale = (OldLambda - NewLambda) / Max(Distance, Small);
+			const VecType FactorA = Scale * FreeA;
+			const VecType FactorB = Scale * FreeB;
+
+			const VecType Correction = Abs(FactorA + FactorB) * Distance;
+			MaxCorrection = Max(MaxCorrection, Correction);
+			SumSquaredCorrection = SumSquaredCorrection + Correction * Correction;
+
+			Scatter(AX + FactorA * DeltaX, PosX, A);
+			Scatter(AY + FactorA * DeltaY, PosY, A);
+			Scatter(AZ + FactorA * DeltaZ, PosZ, A);
+			Scatter(AX + DeltaX - FactorB * DeltaX, PosX, B);
+			Scatter(AY + DeltaY - FactorB * DeltaY, PosY, B);
+			Scatter(AZ + DeltaZ - FactorB * DeltaZ, PosZ, B);
+		}
+
+		VerletClothKernels::FResidual Residual;
+		Residual.MaxCorrection = MaxCorrection.ReduceMax();
+		Residual.SumSquaredCorrection = SumSquaredCorrection.ReduceAdd();
+		return Residual;
+	}
+
+	/** Scales every lane to unit length, lanes too short to have a direction become zero like GetSafeNormal */
+	template<typename VecType>
+	FORCEINLINE void Normalize(VecType& X, VecType& Y, VecType& Z)
+	{
+		const VecType Small = VecType::Splat(SMALL_NUMBER);
+		const VecType SizeSquared = X * X + Y * Y + Z * Z;
+		const VecType Scale = CompareLess(Small, SizeSquared) / Sqrt(Max(SizeSquared, Small));
+		X = X * Scale;
+		Y = Y * Scale;
+		Z = Z * Scale;
+	}
+
+	/** Quantizes a unit vector the way FPackedNormal does, with W set to 255 */
+	FORCEINLINE uint32 PackNormal(float X, float Y, float Z)
+	{
+		auto Quantize = [](float Value) { return (uint32)FMath::Clamp(FMath::TruncToInt(Value * 127.5f + 127.5f), 0, 255); };
+		return Quantize(X) | (Quantize(Y) << 8) | (Quantize(Z) << 16) | (255u << 24);
+	}
+
+	template<typename VecType>
+	void ComputeAerodynamicForcesImpl(const FVerletClothParticles& Particles, const int32* CornerA, const int32* CornerB, const int32* CornerC, int32 Start, int32 End,
+		const float* WindX, const float* WindY, const float* WindZ, float TimeStep, float Drag, float Lift, float* OutForceX, float* OutForceY, float* OutForceZ)
+	{
+		const float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+		const float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+		const float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+		const float* SavedX = Particles.GetStream(FVerletClothParticles::SavedPositionX);
+		const float* SavedY = Particles.GetStream(FVerletClothParticles::SavedPositionY);
+		const float* SavedZ = Particles.GetStream(FVerletClothParticles::SavedPositionZ);
+		const float* Free = Particles.GetStream(FVerletClothParticles::FreeMask);
+
+		const VecType Small = VecType::Splat(SMALL_NUMBER);
+		const VecType Third = VecType::Splat(1.0f / 3.0f);
+		const VecType VelocityScale = VecType::Splat(1.0f / (3.0f * FMath::Max(TimeStep, SMALL_NUMBER)));
+		const VecType NormalScale = VecType::Splat(Drag + Lift);
+		const VecType LiftScale = VecType::Splat(-Lift);
+		for (int32 Idx = Start; Idx + VecType::Width <= End; Idx += VecType::Width)
+		{
+			const int32* A = CornerA + Idx;
+			const int32* B = CornerB + Idx;
+			const int32* C = CornerC + Idx;
+			const VecType AX = Gather<VecType>(PosX, A);
+			const VecType AY = Gather<VecType>(PosY, A);
+			const VecType AZ = Gather<VecType>(PosZ, A);
+			const VecType BX = Gather<VecType>(PosX, B);
+			const VecType BY = Gather<VecType>(PosY, B);
+			const VecType BZ = Gather<VecType>(PosZ, B);
+			const VecType CX = Gather<VecType>(PosX, C);
+			const VecType CY = Gather<VecType>(PosY, C);
+			const VecType CZ = Gather<VecType>(PosZ, C);
+
+			// Wind relative to the triangle, both averaged over the corners.
+			// Saved positions of pinned particles are not their last position, they count as still.
+			const VecType FreeA = Gather<VecType>(Free, A);
+			const VecType FreeB = Gather<VecType>(Free, B);
+			const VecType FreeC = Gather<VecType>(Free, C);
+			const VecType StepX = (AX - Gather<VecType>(SavedX, A)) * FreeA + (BX - Gather<VecType>(SavedX, B)) * FreeB + (CX - Gather<VecType>(SavedX, C)) * FreeC;
+			const VecType StepY = (AY - Gather<VecType>(SavedY, A)) * FreeA + (BY - Gather<VecType>(SavedY, B)) * FreeB + (CY - Gather<VecType>(SavedY, C)) * FreeC;
+			const VecType StepZ = (AZ - Gather<VecType>(SavedZ, A)) * FreeA + (BZ - Gather<VecType>(SavedZ, B)) * FreeB + (CZ - Gather<VecType>(SavedZ, C)) * FreeC;
+			const VecType RelX = (Gather<VecType>(WindX, A) + Gather<VecType>(WindX, B) + Gather<VecType>(WindX, C)) * Third - StepX * VelocityScale;
+			const VecType RelY = (Gather<VecType>(WindY, A) + Gather<VecType>(WindY, B) + Gather<VecType>(WindY, C)) * Third - StepY * VelocityScale;
+			const VecType RelZ = (Gather<VecType>(WindZ, A) + Gather<VecType>(WindZ, B) + Gather<VecType>(WindZ, C)) * Third - StepZ * VelocityScale;
+
+			const VecType ABX = BX - AX;
+			const VecType ABY = BY - AY;
+			const VecType ABZ = BZ - AZ;
+			const VecType ACX = CX - AX;
+			const VecType ACY = CY - AY;
+			const VecType ACZ = CZ - AZ;
+			VecType NormalX = ABY * ACZ - ABZ * ACY;
+			VecType NormalY = ABZ * ACX - ABX * ACZ;
+			VecType NormalZ = ABX * ACY - ABY * ACX;
+			Normalize(NormalX, NormalY, NormalZ);
+
+			// Drag along the normal and lift perpendicular to the relative wind, on the side the wind pushes the triangle to.
+			// Both are independent of the winding:
+			// Normal * (Normal | Rel) * Drag + (Normal - (Normal | Rel) * Rel / |Rel|^2) * (Normal | Rel) * Lift
+			const VecType NormalWind = NormalX * RelX + NormalY * RelY + NormalZ * RelZ;
+			const VecType RelSquared = RelX * RelX + RelY * RelY + RelZ * RelZ;
+			const VecType AlongNormal = NormalWind * NormalScale;
+			const VecType AlongWind = NormalWind * NormalWind * LiftScale / Max(RelSquared, Small);
+
+			(NormalX * AlongNormal + RelX * AlongWind).StoreUnaligned(OutForceX + Idx);
+			(NormalY * AlongNormal + RelY * AlongWind).StoreUnaligned(OutForceY + Idx);
+			(NormalZ * AlongNormal + RelZ * AlongWind).StoreUnaligned(OutForceZ + Idx);
+		}
+	}
+
+	template<typename VecType>
+	void ComputeGridTangentsImpl(const FVector* Positions, int32 NumLines, int32 NumPoints, int32 LineIdx, uint32* OutTangents)
+	{
+		const float* Data = &Positions[0].X;
+
+		// Differences towards the next line and point, from the previous ones on the last line and point.
+		// Lanes past the end of the line repeat the last point and are not written.
+		const int32 Line = LineIdx * NumPoints;
+		const int32 VerticalLine = FMath::Min(LineIdx, NumLines - 2) * NumPoints;
+		for (int32 PointIdx = 0; PointIdx < NumPoints; PointIdx += VecType::Width)
+		{
+			int32 VerticalA[VecType::Width], VerticalB[VecType::Width], RightA[VecType::Width], RightB[VecType::Width];
+			for (int32 Lane = 0; Lane < VecType::Width; ++Lane)
+			{
+				const int32 Point = FMath::Min(PointIdx + Lane, NumPoints - 1);
+				const int32 RightPoint = FMath::Min(Point, NumPoints - 2);
+				VerticalA[Lane] = (VerticalLine + Point) * 3;
+				VerticalB[Lane] = (VerticalLine + NumPoints + Point) * 3;
+				RightA[Lane] = (Line + RightPoint) * 3;
+				RightB[Lane] = RightA[Lane] + 3;
+			}
+
+			VecType VerticalX = Gather<VecType>(Data, VerticalB) - Gather<VecType>(Data, VerticalA);
+			VecType VerticalY = Gather<VecType>(Data + 1, VerticalB) - Gather<VecType>(Data + 1, VerticalA);
+			VecType VerticalZ = Gather<VecType>(Data + 2, VerticalB) - Gather<VecType>(Data + 2, VerticalA);
+			VecType RightX = Gather<VecType>(Data, RightB) - Gather<VecType>(Data, RightA);
+			VecType RightY = Gather<VecType>(Data + 1, RightB) - Gather<VecType>(Data + 1, RightA);
+			VecType RightZ = Gather<VecType>(Data + 2, RightB) - Gather<VecType>(Data + 2, RightA);
+			Normalize(VerticalX, VerticalY, VerticalZ);
+			Normalize(RightX, RightY, RightZ);
+
+			// Right ^ Vertical, the basis is never mirrored
+			VecType UpX = RightY * VerticalZ - RightZ * VerticalY;
+			VecType UpY = RightZ * VerticalX - RightX * VerticalZ;
+			VecType UpZ = RightX * VerticalY - RightY * VerticalX;
+			Normalize(UpX, UpY, UpZ);
+
+			float Values[6][VecType::Width];
+			RightX.StoreUnaligned(Values[0]);
+			RightY.StoreUnaligned(Values[1]);
+			RightZ.StoreUnaligned(Values[2]);
+			UpX.StoreUnaligned(Values[3]);
+			UpY.StoreUnaligned(Values[4]);
+			UpZ.StoreUnaligned(Values[5]);
+
+			const int32 NumLanes = FMath::Min((int32)VecType::Width, NumPoints - PointIdx);
+			for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+			{
+				uint32* Out = OutTangents + (Line + PointIdx + Lane) * 2;
+				Out[0] = PackNormal(Values[0][Lane], Values[1][Lane], Values[2][Lane]);
+				Out[1] = PackNormal(Values[3][Lane], Values[4][Lane], Values[5][Lane]);
+			}
+		}
+	}
+}
+
+bool VerletClothKernels::IsSimdEnabled()
+{
+	return (FVecN::Width > 1) && (CVarVerletClothSimd.GetValueOnAnyThread() != 0);
+}
+
+void VerletClothKernels::SetAcceleration(FVerletClothParticles& Particles, const FVector& Acceleration)
+{
+	if (IsSimdEnabled())
+		SetAccelerationImpl<FVecN>(Particles, Acceleration);
+	else
+		SetAccelerationImpl<FVec1>(Particles, Acceleration);
+}
+
+FBox VerletClothKernels::Integrate(FVerletClothParticles& Particles, float DampingFactor, float TimeSqr, float& OutMaxSquaredStep)
+{
+	FVector Min, Max;
+	if (IsSimdEnabled())
+		IntegrateImpl<FVecN>(Particles, DampingFactor, TimeSqr, Min, Max, OutMaxSquaredStep);
+	else
+		IntegrateImpl<FVec1>(Particles, DampingFactor, TimeSqr, Min, Max, OutMaxSquaredStep);
+
+	// Nothing is free
+	if (Min.X > Max.X)
+		return FBox(0);
+	return FBox(Min, Max);
+}
+
+void VerletClothKernels::ProcessPinnedLine(FVerletClothParticles& Particles, int32 LineIdx, const FVector& Start, const FVector& Delta)
+{
+	int32 PointIdx = 0;
+	if (IsSimdEnabled())
+		PointIdx = ProcessPinnedLineImpl<FVecN>(Particles, LineIdx, Start, Delta);
+
+	for (; PointIdx < Particles.NumPointsPerLine; ++PointIdx)
+	{
+		const int32 Idx = Particles.GetIndex(LineIdx, PointIdx);
+		Particles.SetPosition(Idx, Start + (Delta * PointIdx) + Particles.GetSavedPosition(Idx));
+	}
+}
+
+float VerletClothKernels::GetMaxSquaredStep(const FVerletClothParticles& Particles)
+{
+	if (IsSimdEnabled())
+		return GetMaxSquaredStepImpl<FVecN>(Particles);
+	else
+		return GetMaxSquaredStepImpl<FVec1>(Particles);
+}
+
+FBox VerletClothKernels::ComputeBounds(const FVerletClothParticles& Particles, bool bIncludeSaved)
+{
+	FVector Min(MAX_flt);
+	FVector Max(-MAX_flt);
+
+	// Whole blocks first, padding particles sit at the origin so the remainder is scalar
+	int32 Idx = 0;
+	if (IsSimdEnabled())
+	{
+		Idx = Particles.NumParticles - (Particles.NumParticles % FVecN::Width);
+		ComputeBoundsImpl<FVecN>(Particles, bIncludeSaved, 0, Idx, Min, Max);
+	}
+	ComputeBoundsImpl<FVec1>(Particles, bIncludeSaved, Idx, Particles.NumParticles, Min, Max);
+
+	return FBox(Min, Max);
+}
+
+void VerletClothKernels::ProjectPlane(FVerletClothParticles& Particles, const FPlane& Plane)
+{
+	if (IsSimdEnabled())
+		ProjectPlaneImpl<FVecN>(Particles, Plane);
+	else
+		ProjectPlaneImpl<FVec1>(Particles, Plane);
+}
+
+void VerletClothKernels::CollideCapsule(FVerletClothParticles& Particles, const FVector& Start, const FVector& End, float Radius)
+{
+	if (IsSimdEnabled())
+		CollideCapsuleImpl<FVecN>(Particles, Start, End, Radius);
+	else
+		CollideCapsuleImpl<FVec1>(Particles, Start, End, Radius);
+}
+
+void VerletClothKernels::CollideBox(FVerletClothParticles& Particles, const FVector& Center, const FQuat& Rotation, const FVector& Extent)
+{
+	if (IsSimdEnabled())
+		CollideBoxImpl<FVecN>(Particles, Center, Rotation, Extent);
+	else
+		CollideBoxImpl<FVec1>(Particles, Center, Rotation, Extent);
+}
+
+VerletClothKernels::FResidual VerletClothKernels::SolveDistanceConstraints(FVerletClothParticles& Particles, const int32* IndexA, const int32* IndexB, const float* RestLength, int32 Num, float Relaxation)
+{
+	if (IsSimdEnabled())
+		return SolveDistanceConstraintsImpl<FVecN>(Particles, IndexA, IndexB, RestLength, Num, Relaxation);
+	else
+		return SolveDistanceConstraintsImpl<FVec1>(Particles, IndexA, IndexB, RestLength, Num, Relaxation);
+}
+
+VerletClothKernels::FResidual VerletClothKernels::SolveCompliantDistanceConstraints(FVerletClothParticles& Particles, const int32* IndexA, const int32* IndexB, const float* RestLength, float* Lambda, float Alpha, int32 Num, float Relaxation)
+{
+	if (IsSimdEnabled())
+		return SolveCompliantDistanceConstraintsImpl<FVecN>(Particles, IndexA, IndexB, RestLength, Lambda, Alpha, Num, Relaxation);
+	else
+		return SolveCompliantDistanceConstraintsImpl<FVec1>(Particles, IndexA, IndexB, RestLength, Lambda, Alpha, Num, Relaxation);
+}
+
+void VerletClothKernels::ComputeAerodynamicForces(const FVerletClothParticles& Particles, const int32* CornerA, const int32* CornerB, const int32* CornerC, int32 NumTriangles,
+	const float* WindX, const float* WindY, const float* WindZ, float TimeStep, float Drag, float Lift, float* OutForceX, float* OutForceY, float* OutForceZ)
+{
+	// Whole vectors first, then the remaining triangles one at a time
+	int32 NumVectorized = 0;
+	if (IsSimdEnabled())
+	{
+		NumVectorized = NumTriangles - (NumTriangles % FVecN::Width);
+		ComputeAerodynamicForcesImpl<FVecN>(Particles, CornerA, CornerB, CornerC, 0, NumVectorized, WindX, WindY, WindZ, TimeStep, Drag, Lift, OutForceX, OutForceY, OutForceZ);
+	}
+	ComputeAerodynamicForcesImpl<FVec1>(Particles, CornerA, CornerB, CornerC, NumVectorized, NumTriangles, WindX, WindY, WindZ, TimeStep, Drag, Lift, OutForceX, OutForceY, OutForceZ);
+}
+
+void VerletClothKernels::ComputeGridTangents(const FVector* Positions, int32 NumLines, int32 NumPoints, int32 LineIdx, uint32* OutTangents)
+{
+	if (IsSimdEnabled())
+		ComputeGridTangentsImpl<FVecN>(Positions, NumLines, NumPoints, LineIdx, OutTangents);
+	else
+		ComputeGridTangentsImpl<FVec1>(Positions, NumLines, NumPoints, LineIdx, OutTangents);
+}
+
+void VerletClothKernels::ComputeGridTangents(const FVector* Positions, int32 NumLines, int32 NumPoints, uint32* OutTangents)
+{
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumLines, TangentLinesPerTask);
+	ParallelFor(NumChunks, [&](int32 ChunkIdx)
+	{
+		const int32 LastLine = FMath::Min((ChunkIdx + 1) * TangentLinesPerTask, NumLines);
+		for (int32 LineIdx = ChunkIdx * TangentLinesPerTask; LineIdx < LastLine; LineIdx++)
+			ComputeGridTangents(Positions, NumLines, NumPoints, LineIdx, OutTangents);
+	}, NumChunks == 1);
+}
@@ -0,0 +1,97 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+struct FVerletClothParticles;
+
+/**
+ * Vectorized per-particle kernels working on the particle streams.
+ * Every kernel processes the whole padded streams, padding particles are pinned and never move.
+ * The scalar path can be forced at runtime with verletcloth.Simd 0.
+ */
+namespace VerletClothKernels
+{
+	/** Returns true if the vectorized path is used */
+	bool IsSimdEnabled();
+
+	/** Sets the acceleration of every particle */
+	void SetAcceleration(FVerletClothParticles& Particles, const FVector& Acceleration);
+
+	/**
+	 * Damped verlet step of every free particle, pinned particles keep both of their positions.
+	 * Returns the bounds of the free particles once moved and their longest squared step in OutMaxSquaredStep, gathered on the way.
+	 */
+	FBox Integrate(FVerletClothParticles& Particles, float DampingFactor, float TimeSqr, float& OutMaxSquaredStep);
+
+	/** Moves every point of a pinned line to Start + Delta * PointIdx + SavedPosition */
+	void ProcessPinnedLine(FVerletClothParticles& Particles, int32 LineIdx, const FVector& Start, const FVector& Delta);
+
+	/** Returns the largest squared distance between the position and the saved position of free particles, how far they moved in the last step */
+	float GetMaxSquaredStep(const FVerletClothParticles& Particles);
+
+	/** Returns the bounds of every particle, including the saved positions of free particles if bIncludeSaved is set */
+	FBox ComputeBounds(const FVerletClothParticles& Particles, bool bIncludeSaved);
+
+	/** Pushes free particles behind the plane back onto it */
+	void ProjectPlane(FVerletClothParticles& Particles, const FPlane& Plane);
+
+	/** Pushes free particles out of the capsule around the segment from Start to End, a sphere when both are the same */
+	void CollideCapsule(FVerletClothParticles& Particles, const FVector& Start, const FVector& End, float Radius);
+
+	/** Pushes free particles out of the oriented box through its closest face */
+	void CollideBox(FVerletClothParticles& Particles, const FVector& Center, const FQuat& Rotation, const FVector& Extent);
+
+	/** How far constraints moved their particles during a solver sweep, tells how close it is to converging */
+	struct FResidual
+	{
+		FResidual()
+		: MaxCorrection(0.0f)
+		, SumSquaredCorrection(0.0f)
+		{}
+
+		void Add(float Correction)
+		{
+			MaxCorrection = FMath::Max(MaxCorrection, Correction);
+			SumSquaredCorrection += Correction * Correction;
+		}
+
+		void Add(const FResidual& Other)
+		{
+			MaxCorrection = FMath::Max(MaxCorrection, Other.MaxCorrection);
+			SumSquaredCorrection += Other.SumSquaredCorrection;
+		}
+
+		float MaxCorrection;
+		float SumSquaredCorrection;
+	};
+
+	/**
+	 * Pulls the particles of stretched distance constraints back together, only moving free particles.
+	 * Corrections are scaled by Relaxation, padding constraints add nothing to the residual.
+	 * Constraints must not share particles and Num must be a multiple of FVerletClothParticles::StreamAlignment.
+	 */
+	FResidual SolveDistanceConstraints(FVerletClothParticles& Particles, const int32* IndexA, const int32* IndexB, const float* RestLength, int32 Num, float Relaxation);
+
+	/**
+	 * XPBD version of SolveDistanceConstraints, Alpha is the compliance divided by the squared substep time.
+	 * Lambda holds the multiplier of each constraint accumulated over the substep.
+	 */
+	FResidual SolveCompliantDistanceConstraints(FVerletClothParticles& Particles, const int32* IndexA, const int32* IndexB, const float* RestLength, float* Lambda, float Alpha, int32 Num, float Relaxation);
+
+	/**
+	 * Aerodynamic force on every triangle from the wind relative to the triangle, its normal computed once.
+	 * Drag pushes along the normal and lift across the relative wind. Wind is sampled per particle and averaged over the corners,
+	 * the velocity of the corners is their last step over TimeStep. Triangles need no padding.
+	 */
+	void ComputeAerodynamicForces(const FVerletClothParticles& Particles, const int32* CornerA, const int32* CornerB, const int32* CornerC, int32 NumTriangles,
+		const float* WindX, const float* WindY, const float* WindZ, float TimeStep, float Drag, float Lift, float* OutForceX, float* OutForceY, float* OutForceZ);
+
+	/**
+	 * Tangent frames of the points of one line of a grid laid out line by line, with at least two lines and two points per line.
+	 * Writes two normals packed like FPackedNormal per point, the direction along the line then the normal.
+	 */
+	void ComputeGridTangents(const FVector* Positions, int32 NumLines, int32 NumPoints, int32 LineIdx, uint32* OutTangents);
+
+	/** Tangent frames of every line of a grid, lines are independent so a few of them are built per task on worker threads */
+	void ComputeGridTangents(const FVector* Positions, int32 NumLines, int32 NumPoints, uint32* OutTangents);
+}
@@ -0,0 +1,140 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothSelfCollision.h"
+#include "ParallelFor.h"
+
+static TAutoConsoleVariable<int32> CVarVerletClothSelfCollisionChunkSize(
+	TEXT("verletcloth.SelfCollision.ChunkSize"),
+	256,
+	TEXT("Number of particles hashed or solved by a single task of the self collision."),
+	ECVF_Default);
+
+//////////////////////////////////////////////////////////////////////////
+// FVerletClothSpatialHash
+
+FVerletClothSpatialHash::FVerletClothSpatialHash()
+	: CellSize(0.0f)
+	, InvCellSize(0.0f)
+	, NumParticles(0)
+	, NumBuckets(0)
+{}
+
+void FVerletClothSpatialHash::Build(const FVerletClothParticles& Particles, float InCellSize, int32 ChunkSize)
+{
+	// A new grid or cell size hashes everything again
+	const bool bReset = (Particles.NumParticles != NumParticles || InCellSize != CellSize);
+	if (bReset)
+	{
+		CellSize = InCellSize;
+		InvCellSize = 1.0f / InCellSize;
+		NumParticles = Particles.NumParticles;
+		NumBuckets = FMath::RoundUpToPowerOfTwo(FMath::Max(NumParticles * 2, 16));
+		ParticleCells.SetNumUninitialized(NumParticles);
+		ParticleBuckets.SetNumUninitialized(NumParticles);
+		BucketStart.SetNumUninitialized(NumBuckets + 1);
+		SortedParticles.SetNumUninitialized(NumParticles);
+	}
+
+	const float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+	const float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+	const float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumParticles, ChunkSize);
+	ChunkChanged.SetNumUninitialized(NumChunks);
+	ParallelFor(NumChunks, [&](int32 ChunkIdx)
+	{
+		bool bChanged = bReset;
+		const int32 End = FMath::Min(NumParticles, (ChunkIdx + 1) * ChunkSize);
+		for (int32 Idx = ChunkIdx * ChunkSize; Idx < End; ++Idx)
+		{
+			const FIntVector Cell = GetCell(FVector(PosX[Idx], PosY[Idx], PosZ[Idx]));
+			if (bReset || Cell != ParticleCells[Idx])
+			{
+				ParticleCells[Idx] = Cell;
+				ParticleBuckets[Idx] = GetBucket(Cell);
+				bChanged = true;
+			}
+		}
+		ChunkChanged[ChunkIdx] = bChanged;
+	}, NumChunks == 1);
+
+	// Slow cloth stays in its cells for many substeps in a row
+	if (!ChunkChanged.Contains(true))
+		return;
+
+	// Counting sort, linear and serial so the order within a bucket never depends on the threads
+	FMemory::Memzero(BucketStart.GetData(), BucketStart.Num() * sizeof(int32));
+	for (int32 Idx = 0; Idx < NumParticles; ++Idx)
+		BucketStart[ParticleBuckets[Idx]]++;
+
+	int32 Sum = 0;
+	for (int32 Bucket = 0; Bucket <= NumBuckets; ++Bucket)
+	{
+		Sum += BucketStart[Bucket];
+		BucketStart[Bucket] = Sum;
+	}
+
+	// Filled backwards from the end of every bucket, which leaves it at the bucket's start
+	for (int32 Idx = NumParticles - 1; Idx >= 0; --Idx)
+		SortedParticles[--BucketStart[ParticleBuckets[Idx]]] = Idx;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FVerletClothSelfCollision
+
+void FVerletClothSelfCollision::Solve(FVerletClothParticles& Particles, float Thickness, const TArray<FVector>& RestPositions)
+{
+	const int32 ChunkSize = FMath::Max(CVarVerletClothSelfCollisionChunkSize.GetValueOnAnyThread(), 1);
+	Hash.Build(Particles, Thickness, ChunkSize);
+
+	float* PosX = Particles.GetStream(FVerletClothParticles::PositionX);
+	float* PosY = Particles.GetStream(FVerletClothParticles::PositionY);
+	float* PosZ = Particles.GetStream(FVerletClothParticles::PositionZ);
+	const float* Free = Particles.GetStream(FVerletClothParticles::FreeMask);
+
+	const int32 NumParticles = Particles.NumParticles;
+	const float ThicknessSqr = Thickness * Thickness;
+	Corrections.SetNumUninitialized(NumParticles);
+
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumParticles, ChunkSize);
+	ParallelFor(NumChunks, [&](int32 ChunkIdx)
+	{
+		const int32 End = FMath::Min(NumParticles, (ChunkIdx + 1) * ChunkSize);
+		for (int32 Idx = ChunkIdx * ChunkSize; Idx < End; ++Idx)
+		{
+			FVector Correction = FVector::ZeroVector;
+			if (Free[Idx] != 0.0f)
+			{
+				const FVector Position(PosX[Idx], PosY[Idx], PosZ[Idx]);
+				const FVector& RestPosition = RestPositions[Idx];
+				Hash.ForEachNeighbor(Position, [&](int32 OtherIdx)
+				{
+					if (FVector::DistSquared(RestPosition, RestPositions[OtherIdx]) < ThicknessSqr)
+						return;
+
+					const FVector Delta = Position - FVector(PosX[OtherIdx], PosY[OtherIdx], PosZ[OtherIdx]);
+					const float DistSqr = Delta.SizeSquared();
+					if (DistSqr >= ThicknessSqr || DistSqr <= SMALL_NUMBER)
+						return;
+
+					// Both particles move half of the overlap, this one all of it against a pinned particle
+					const float Distance = FMath::Sqrt(DistSqr);
+					Correction += Delta * ((Thickness - Distance) / Distance * (Free[OtherIdx] != 0.0f ? 0.5f : 1.0f));
+				});
+			}
+			Corrections[Idx] = Correction;
+		}
+	}, NumChunks == 1);
+
+	ParallelFor(NumChunks, [&](int32 ChunkIdx)
+	{
+		const int32 End = FMath::Min(NumParticles, (ChunkIdx + 1) * ChunkSize);
+		for (int32 Idx = ChunkIdx * ChunkSize; Idx < End; ++Idx)
+		{
+			PosX[Idx] += Corrections[Idx].X;
+			PosY[Idx] += Corrections[Idx].Y;
+			PosZ[Idx] += Corrections[Idx].Z;
+		}
+	}, NumChunks == 1);
+}
@@ -0,0 +1,106 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+struct FVerletClothParticles;
+
+/**
+ * Uniform grid over the particles, hashed into a table about twice the particle count.
+ * Buckets are stored as a counting sort: the particles of a bucket are contiguous in SortedParticles,
+ * from BucketStart[Bucket] to BucketStart[Bucket + 1]. Positions are always read from the particles,
+ * so the table only needs sorting again when a particle changed cells.
+ */
+class FVerletClothSpatialHash
+{
+public:
+
+	FVerletClothSpatialHash();
+
+	/** Hashes every particle in cells of CellSize, cells are computed in parallel over chunks of ChunkSize particles */
+	void Build(const FVerletClothParticles& Particles, float InCellSize, int32 ChunkSize);
+
+	/** Calls Visitor(Idx) for every particle in the cell of Position and the ones around it, so every particle within CellSize is visited once */
+	template<typename VisitorType>
+	void ForEachNeighbor(const FVector& Position, VisitorType Visitor) const
+	{
+		const FIntVector Center = GetCell(Position);
+		for (int32 Z = Center.Z - 1; Z <= Center.Z + 1; ++Z)
+		{
+			for (int32 Y = Center.Y - 1; Y <= Center.Y + 1; ++Y)
+			{
+				for (int32 X = Center.X - 1; X <= Center.X + 1; ++X)
+				{
+					// Other cells may share the bucket, only their own particles are visited
+					const FIntVector Cell(X, Y, Z);
+					const int32 Bucket = GetBucket(Cell);
+					for (int32 SortedIdx = BucketStart[Bucket]; SortedIdx < BucketStart[Bucket + 1]; ++SortedIdx)
+					{
+						const int32 Idx = SortedParticles[SortedIdx];
+						if (ParticleCells[Idx] == Cell)
+							Visitor(Idx);
+					}
+				}
+			}
+		}
+	}
+
+	uint32 GetAllocatedSize() const
+	{
+		return ParticleCells.GetAllocatedSize() + ParticleBuckets.GetAllocatedSize() + ChunkChanged.GetAllocatedSize() + BucketStart.GetAllocatedSize() + SortedParticles.GetAllocatedSize();
+	}
+
+private:
+
+	FIntVector GetCell(const FVector& Position) const
+	{
+		return FIntVector(FMath::FloorToInt(Position.X * InvCellSize), FMath::FloorToInt(Position.Y * InvCellSize), FMath::FloorToInt(Position.Z * InvCellSize));
+	}
+
+	int32 GetBucket(const FIntVector& Cell) const
+	{
+		const uint32 Hash = ((uint32)Cell.X * 73856093u) ^ ((uint32)Cell.Y * 19349663u) ^ ((uint32)Cell.Z * 83492791u);
+		return (int32)(Hash & (uint32)(NumBuckets - 1));
+	}
+
+	float CellSize;
+	float InvCellSize;
+	int32 NumParticles;
+	/** Power of two */
+	int32 NumBuckets;
+
+	/** Cell and bucket of every particle at the last build */
+	TArray<FIntVector> ParticleCells;
+	TArray<int32> ParticleBuckets;
+	/** Set for the chunks where a particle changed cells */
+	TArray<bool> ChunkChanged;
+
+	/** First sorted particle of every bucket, and the particle count at the end */
+	TArray<int32> BucketStart;
+	/** Particle indices ordered by bucket, then by index */
+	TArray<int32> SortedParticles;
+};
+
+/**
+ * Keeps particles of the cloth at least a thickness apart, so the cloth does not pass through itself.
+ * Particles closer than the thickness in the rest shape are skipped, they would push each other apart forever.
+ * Every particle gathers its correction from the positions before the pass, so chunks of particles are solved in parallel.
+ */
+class FVerletClothSelfCollision
+{
+public:
+
+	/** Pushes overlapping free particles apart, RestPositions being the rest shape of the topology */
+	void Solve(FVerletClothParticles& Particles, float Thickness, const TArray<FVector>& RestPositions);
+
+	uint32 GetAllocatedSize() const
+	{
+		return Hash.GetAllocatedSize() + Corrections.GetAllocatedSize();
+	}
+
+private:
+
+	FVerletClothSpatialHash Hash;
+
+	/** Position change of every particle in the current pass */
+	TArray<FVector> Corrections;
+};
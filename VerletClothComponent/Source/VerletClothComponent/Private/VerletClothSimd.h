@@ -0,0 +1,176 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+/**
+ * Minimal SIMD abstraction used by the cloth kernels.
+ * FVecN is the widest lane block available for the target: 8 lanes with AVX, 4 lanes with SSE,
+ * otherwise a single float. FVec1 is always available as the scalar reference path.
+ * Particle streams are aligned and padded to FVerletClothParticles::StreamAlignment floats, so kernels walking
+ * whole streams never need a remainder loop.
+ */
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS && defined(__AVX__)
+	#define VERLETCLOTH_SIMD_AVX 1
+	#define VERLETCLOTH_SIMD_SSE 0
+	#include <immintrin.h>
+#elif PLATFORM_ENABLE_VECTORINTRINSICS && (defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__))
+	#define VERLETCLOTH_SIMD_AVX 0
+	#define VERLETCLOTH_SIMD_SSE 1
+	#include <emmintrin.h>
+#else
+	#define VERLETCLOTH_SIMD_AVX 0
+	#define VERLETCLOTH_SIMD_SSE 0
+#endif
+
+namespace VerletClothSimd
+{
+	/** Scalar lane block */
+	struct FVec1
+	{
+		enum { Width = 1 };
+
+		float V;
+
+		FORCEINLINE FVec1() {}
+		FORCEINLINE FVec1(float InV) : V(InV) {}
+
+		static FORCEINLINE FVec1 Load(const float* Ptr) { return FVec1(*Ptr); }
+		static FORCEINLINE FVec1 LoadUnaligned(const float* Ptr) { return FVec1(*Ptr); }
+		static FORCEINLINE FVec1 Splat(float Value) { return FVec1(Value); }
+		/** Returns (Start, Start + 1, ... Start + Width - 1) */
+		static FORCEINLINE FVec1 Ramp(float Start) { return FVec1(Start); }
+		FORCEINLINE void Store(float* Ptr) const { *Ptr = V; }
+		FORCEINLINE void StoreUnaligned(float* Ptr) const { *Ptr = V; }
+
+		FORCEINLINE float ReduceMin() const { return V; }
+		FORCEINLINE float ReduceMax() const { return V; }
+		FORCEINLINE float ReduceAdd() const { return V; }
+	};
+
+	FORCEINLINE FVec1 operator+(FVec1 A, FVec1 B) { return FVec1(A.V + B.V); }
+	FORCEINLINE FVec1 operator-(FVec1 A, FVec1 B) { return FVec1(A.V - B.V); }
+	FORCEINLINE FVec1 operator*(FVec1 A, FVec1 B) { return FVec1(A.V * B.V); }
+	FORCEINLINE FVec1 operator/(FVec1 A, FVec1 B) { return FVec1(A.V / B.V); }
+	FORCEINLINE FVec1 Min(FVec1 A, FVec1 B) { return FVec1(A.V < B.V ? A.V : B.V); }
+	FORCEINLINE FVec1 Max(FVec1 A, FVec1 B) { return FVec1(A.V > B.V ? A.V : B.V); }
+	FORCEINLINE FVec1 Sqrt(FVec1 A) { return FVec1(FMath::Sqrt(A.V)); }
+	/** 1 in the lanes where A < B, 0 elsewhere */
+	FORCEINLINE FVec1 CompareLess(FVec1 A, FVec1 B) { return FVec1(A.V < B.V ? 1.0f : 0.0f); }
+
+#if VERLETCLOTH_SIMD_SSE || VERLETCLOTH_SIMD_AVX
+	/** 4 lanes SSE block */
+	struct FVec4
+	{
+		enum { Width = 4 };
+
+		__m128 V;
+
+		FORCEINLINE FVec4() {}
+		FORCEINLINE FVec4(__m128 InV) : V(InV) {}
+
+		static FORCEINLINE FVec4 Load(const float* Ptr) { return FVec4(_mm_load_ps(Ptr)); }
+		static FORCEINLINE FVec4 LoadUnaligned(const float* Ptr) { return FVec4(_mm_loadu_ps(Ptr)); }
+		static FORCEINLINE FVec4 Splat(float Value) { return FVec4(_mm_set1_ps(Value)); }
+		static FORCEINLINE FVec4 Ramp(float Start) { return FVec4(_mm_add_ps(_mm_set1_ps(Start), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f))); }
+		FORCEINLINE void Store(float* Ptr) const { _mm_store_ps(Ptr, V); }
+		FORCEINLINE void StoreUnaligned(float* Ptr) const { _mm_storeu_ps(Ptr, V); }
+
+		FORCEINLINE float ReduceMin() const
+		{
+			__m128 R = _mm_min_ps(V, _mm_shuffle_ps(V, V, _MM_SHUFFLE(1, 0, 3, 2)));
+			R = _mm_min_ps(R, _mm_shuffle_ps(R, R, _MM_SHUFFLE(2, 3, 0, 1)));
+			return _mm_cvtss_f32(R);
+		}
+
+		FORCEINLINE float ReduceMax() const
+		{
+			__m128 R = _mm_max_ps(V, _mm_shuffle_ps(V, V, _MM_SHUFFLE(1, 0, 3, 2)));
+			R = _mm_max_ps(R, _mm_shuffle_ps(R, R, _MM_SHUFFLE(2, 3, 0, 1)));
+			return _mm_cvtss_f32(R);
+		}
+
+		FORCEINLINE float ReduceAdd() const
+		{
+			__m128 R = _mm_add_ps(V, _mm_shuffle_ps(V, V, _MM_SHUFFLE(1, 0, 3, 2)));
+			R = _mm_add_ps(R, _mm_shuffle_ps(R, R, _MM_SHUFFLE(2, 3, 0, 1)));
+			return _mm_cvtss_f32(R);
+		}
+	};
+
+	FORCEINLINE FVec4 operator+(FVec4 A, FVec4 B) { return FVec4(_mm_add_ps(A.V, B.V)); }
+	FORCEINLINE FVec4 operator-(FVec4 A, FVec4 B) { return FVec4(_mm_sub_ps(A.V, B.V)); }
+	FORCEINLINE FVec4 operator*(FVec4 A, FVec4 B) { return FVec4(_mm_mul_ps(A.V, B.V)); }
+	FORCEINLINE FVec4 operator/(FVec4 A, FVec4 B) { return FVec4(_mm_div_ps(A.V, B.V)); }
+	FORCEINLINE FVec4 Min(FVec4 A, FVec4 B) { return FVec4(_mm_min_ps(A.V, B.V)); }
+	FORCEINLINE FVec4 Max(FVec4 A, FVec4 B) { return FVec4(_mm_max_ps(A.V, B.V)); }
+	FORCEINLINE FVec4 Sqrt(FVec4 A) { return FVec4(_mm_sqrt_ps(A.V)); }
+	FORCEINLINE FVec4 CompareLess(FVec4 A, FVec4 B) { return FVec4(_mm_and_ps(_mm_cmplt_ps(A.V, B.V), _mm_set1_ps(1.0f))); }
+#endif
+
+#if VERLETCLOTH_SIMD_AVX
+	/** 8 lanes AVX block */
+	struct FVec8
+	{
+		enum { Width = 8 };
+
+		__m256 V;
+
+		FORCEINLINE FVec8() {}
+		FORCEINLINE FVec8(__m256 InV) : V(InV) {}
+
+		static FORCEINLINE FVec8 Load(const float* Ptr) { return FVec8(_mm256_load_ps(Ptr)); }
+		static FORCEINLINE FVec8 LoadUnaligned(const float* Ptr) { return FVec8(_mm256_loadu_ps(Ptr)); }
+		static FORCEINLINE FVec8 Splat(float Value) { return FVec8(_mm256_set1_ps(Value)); }
+		static FORCEINLINE FVec8 Ramp(float Start) { return FVec8(_mm256_add_ps(_mm256_set1_ps(Start), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f))); }
+		FORCEINLINE void Store(float* Ptr) const { _mm256_store_ps(Ptr, V); }
+		FORCEINLINE void StoreUnaligned(float* Ptr) const { _mm256_storeu_ps(Ptr, V); }
+
+		FORCEINLINE float ReduceMin() const { return FVec4(_mm_min_ps(_mm256_castps256_ps128(V), _mm256_extractf128_ps(V, 1))).ReduceMin(); }
+		FORCEINLINE float ReduceMax() const { return FVec4(_mm_max_ps(_mm256_castps256_ps128(V), _mm256_extractf128_ps(V, 1))).ReduceMax(); }
+		FORCEINLINE float ReduceAdd() const { return FVec4(_mm_add_ps(_mm256_castps256_ps128(V), _mm256_extractf128_ps(V, 1))).ReduceAdd(); }
+	};
+
+	FORCEINLINE FVec8 operator+(FVec8 A, FVec8 B) { return FVec8(_mm256_add_ps(A.V, B.V)); }
+	FORCEINLINE FVec8 operator-(FVec8 A, FVec8 B) { return FVec8(_mm256_sub_ps(A.V, B.V)); }
+	FORCEINLINE FVec8 operator*(FVec8 A, FVec8 B) { return FVec8(_mm256_mul_ps(A.V, B.V)); }
+	FORCEINLINE FVec8 operator/(FVec8 A, FVec8 B) { return FVec8(_mm256_div_ps(A.V, B.V)); }
+	FORCEINLINE FVec8 Min(FVec8 A, FVec8 B) { return FVec8(_mm256_min_ps(A.V, B.V)); }
+	FORCEINLINE FVec8 Max(FVec8 A, FVec8 B) { return FVec8(_mm256_max_ps(A.V, B.V)); }
+	FORCEINLINE FVec8 Sqrt(FVec8 A) { return FVec8(_mm256_sqrt_ps(A.V)); }
+	FORCEINLINE FVec8 CompareLess(FVec8 A, FVec8 B) { return FVec8(_mm256_and_ps(_mm256_cmp_ps(A.V, B.V, _CMP_LT_OQ), _mm256_set1_ps(1.0f))); }
+
+	typedef FVec8 FVecN;
+#elif VERLETCLOTH_SIMD_SSE
+	typedef FVec4 FVecN;
+#else
+	typedef FVec1 FVecN;
+#endif
+
+	/** Absolute value of every lane */
+	template<typename VecType>
+	FORCEINLINE VecType Abs(const VecType& A)
+	{
+		return Max(A, VecType::Splat(0.0f) - A);
+	}
+
+	/** Loads Stream[Indices[0]] .. Stream[Indices[Width - 1]] */
+	template<typename VecType>
+	FORCEINLINE VecType Gather(const float* Stream, const int32* Indices)
+	{
+		float Values[VecType::Width];
+		for (int32 Lane = 0; Lane < VecType::Width; ++Lane)
+			Values[Lane] = Stream[Indices[Lane]];
+		return VecType::LoadUnaligned(Values);
+	}
+
+	/** Stores the lanes to Stream[Indices[0]] .. Stream[Indices[Width - 1]], in lane order */
+	template<typename VecType>
+	FORCEINLINE void Scatter(const VecType& Value, float* Stream, const int32* Indices)
+	{
+		float Values[VecType::Width];
+		Value.StoreUnaligned(Values);
+		for (int32 Lane = 0; Lane < VecType::Width; ++Lane)
+			Stream[Indices[Lane]] = Values[Lane];
+	}
+}
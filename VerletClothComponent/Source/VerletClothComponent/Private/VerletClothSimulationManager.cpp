@@ -0,0 +1,221 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothSimulationManager.h"
+#include "VerletClothStats.h"
+#include "ParallelFor.h"
+
+static TAutoConsoleVariable<int32> CVarVerletClothUseSimulationManager(
+	TEXT("verletcloth.UseSimulationManager"),
+	1,
+	TEXT("Simulate cloth components from one manager per world instead of their own tick. Applies to components registered afterwards."),
+	ECVF_Default);
+
+TMap<UWorld*, FVerletClothSimulationManager*> FVerletClothSimulationManager::WorldManagers;
+FDelegateHandle FVerletClothSimulationManager::OnWorldCleanupHandle;
+
+//////////////////////////////////////////////////////////////////////////
+// FVerletClothSimulationManagerTickFunction
+
+void FVerletClothSimulationManagerTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	check(Manager);
+	if (bAsync)
+		Manager->TickAsync(DeltaTime, TickType);
+	else
+		Manager->Tick(DeltaTime, TickType);
+}
+
+FString FVerletClothSimulationManagerTickFunction::DiagnosticMessage()
+{
+	return bAsync ? TEXT("FVerletClothSimulationManagerTickFunction[Async]") : TEXT("FVerletClothSimulationManagerTickFunction");
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FVerletClothSimulationManager
+
+FVerletClothSimulationManager::FVerletClothSimulationManager(UWorld* InWorld)
+	: World(InWorld)
+{
+	TickFunction.Manager = this;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.TickGroup = TG_PostUpdateWork;
+	TickFunction.RegisterTickFunction(World->PersistentLevel);
+
+	AsyncTickFunction.Manager = this;
+	AsyncTickFunction.bAsync = true;
+	AsyncTickFunction.bCanEverTick = true;
+	AsyncTickFunction.bStartWithTickEnabled = true;
+	AsyncTickFunction.TickGroup = TG_PrePhysics;
+	AsyncTickFunction.RegisterTickFunction(World->PersistentLevel);
+}
+
+FVerletClothSimulationManager::~FVerletClothSimulationManager()
+{
+	if (AsyncBatchEvent.GetReference() && !AsyncBatchEvent->IsComplete())
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(AsyncBatchEvent, ENamedThreads::GameThread);
+
+	TickFunction.UnRegisterTickFunction();
+	AsyncTickFunction.UnRegisterTickFunction();
+}
+
+FVerletClothSimulationManager* FVerletClothSimulationManager::Get(UWorld* World)
+{
+	check(IsInGameThread());
+	check(World && World->PersistentLevel);
+
+	FVerletClothSimulationManager*& Manager = WorldManagers.FindOrAdd(World);
+	if (Manager == NULL)
+		Manager = new FVerletClothSimulationManager(World);
+	return Manager;
+}
+
+FVerletClothSimulationManager* FVerletClothSimulationManager::Find(UWorld* World)
+{
+	check(IsInGameThread());
+
+	FVerletClothSimulationManager** Manager = WorldManagers.Find(World);
+	return Manager ? *Manager : NULL;
+}
+
+bool FVerletClothSimulationManager::IsEnabled()
+{
+	return CVarVerletClothUseSimulationManager.GetValueOnGameThread() != 0;
+}
+
+void FVerletClothSimulationManager::OnStartup()
+{
+	OnWorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddStatic(&FVerletClothSimulationManager::OnWorldCleanup);
+}
+
+void FVerletClothSimulationManager::OnShutdown()
+{
+	FWorldDelegates::OnWorldCleanup.Remove(OnWorldCleanupHandle);
+
+	for (auto& Pair : WorldManagers)
+		delete Pair.Value;
+	WorldManagers.Empty();
+}
+
+void FVerletClothSimulationManager::OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	FVerletClothSimulationManager* Manager = NULL;
+	if (!WorldManagers.RemoveAndCopyValue(World, Manager))
+		return;
+
+	// Components still registered go to a new manager when they register again, after their simulation in flight completed
+	for (UVerletClothComponent* Component : Manager->Components)
+	{
+		Component->CompleteAsyncSimulation();
+		Component->bSimulatedByManager = false;
+	}
+	delete Manager;
+}
+
+void FVerletClothSimulationManager::AddComponent(UVerletClothComponent* Component)
+{
+	Components.AddUnique(Component);
+}
+
+void FVerletClothSimulationManager::RemoveComponent(UVerletClothComponent* Component)
+{
+	Components.RemoveSwap(Component);
+
+	// The component completed its async simulation before unregistering, so the batch is not running anymore
+	const int32 AsyncIdx = AsyncComponents.Find(Component);
+	if (AsyncIdx != INDEX_NONE)
+	{
+		AsyncComponents.RemoveAtSwap(AsyncIdx);
+		AsyncInputs.RemoveAtSwap(AsyncIdx);
+	}
+}
+
+void FVerletClothSimulationManager::GatherComponents(bool bAsync, float DeltaTime, ELevelTick TickType, TArray<UVerletClothComponent*>& OutComponents, TArray<FVerletClothSimulationInput>& OutInputs) const
+{
+	OutComponents.Reset();
+	OutInputs.Reset();
+	if (Components.Num() == 0)
+		return;
+
+	// World settings are the same for every component
+	AWorldSettings* WorldSettings = World->GetWorldSettings();
+	check(WorldSettings);
+	const float TimeDilation = WorldSettings->GetEffectiveTimeDilation();
+	const float WorldGravityZ = WorldSettings->GetGravityZ();
+
+	for (UVerletClothComponent* Component : Components)
+	{
+		if (Component->bAsyncSimulation != bAsync)
+			continue;
+
+		if (!Component->IsActive() || Component->IsPendingKill())
+			continue;
+
+		if (TickType == LEVELTICK_ViewportsOnly && !Component->bTickInEditor)
+			continue;
+
+		// No simulation of this component is running, so the LOD can switch grids
+		Component->UpdateLOD(DeltaTime);
+
+		FVerletClothSimulationInput Input = Component->GatherSimulationInput(DeltaTime, TimeDilation, WorldGravityZ);
+		if (!Component->ShouldSimulate(Input) || !Component->ThrottleSimulation(Input))
+			continue;
+
+		OutComponents.Add(Component);
+		OutInputs.Add(Input);
+	}
+}
+
+void FVerletClothSimulationManager::Tick(float DeltaTime, ELevelTick TickType)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_ManagerTick);
+
+	// Gather
+	GatherComponents(false, DeltaTime, TickType, TickedComponents, TickedInputs);
+
+	// Simulate
+	ParallelFor(TickedComponents.Num(), [this](int32 Idx)
+	{
+		TickedComponents[Idx]->Simulate(TickedInputs[Idx]);
+	});
+
+	// Write back
+	for (UVerletClothComponent* Component : TickedComponents)
+		Component->FinishSimulation();
+}
+
+void FVerletClothSimulationManager::TickAsync(float DeltaTime, ELevelTick TickType)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_ManagerTick);
+
+	// Publish last frame's batch, it had a whole frame to complete so this rarely waits
+	if (AsyncBatchEvent.GetReference())
+	{
+		if (!AsyncBatchEvent->IsComplete())
+			FTaskGraphInterface::Get().WaitUntilTaskCompletes(AsyncBatchEvent, ENamedThreads::GameThread);
+		AsyncBatchEvent = NULL;
+	}
+
+	for (UVerletClothComponent* Component : AsyncComponents)
+	{
+		Component->CompleteAsyncSimulation();
+		Component->FinishSimulation();
+	}
+
+	// Kick this frame's batch
+	GatherComponents(true, DeltaTime, TickType, AsyncComponents, AsyncInputs);
+	if (AsyncComponents.Num() == 0)
+		return;
+
+	AsyncBatchEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([this]()
+	{
+		ParallelFor(AsyncComponents.Num(), [this](int32 Idx)
+		{
+			AsyncComponents[Idx]->SimulateAsync(AsyncInputs[Idx]);
+		});
+	}, GET_STATID(STAT_VerletCloth_AsyncTask), NULL, ENamedThreads::AnyThread);
+
+	for (UVerletClothComponent* Component : AsyncComponents)
+		Component->AsyncSimulationEvent = AsyncBatchEvent;
+}
@@ -0,0 +1,90 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+class UVerletClothComponent;
+class FVerletClothSimulationManager;
+
+/** Tick function of the simulation manager, in TG_PostUpdateWork for synchronous components and TG_PrePhysics for async ones */
+struct FVerletClothSimulationManagerTickFunction : public FTickFunction
+{
+	FVerletClothSimulationManagerTickFunction()
+	: Manager(NULL), bAsync(false)
+	{}
+
+	//~ Begin FTickFunction Interface.
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	//~ End FTickFunction Interface.
+
+	FVerletClothSimulationManager* Manager;
+
+	/** Ticks the async components */
+	bool bAsync;
+};
+
+/**
+ * Simulates every cloth component of a world from a single tick.
+ * Inputs are gathered once on the game thread, the components are simulated in parallel on worker threads,
+ * and the results are written back in one pass.
+ * Components in async mode are kicked as one batch task at the start of the frame and completed at the start of the next one.
+ */
+class FVerletClothSimulationManager
+{
+public:
+
+	/** Returns the manager of the world, creating it on first use */
+	static FVerletClothSimulationManager* Get(UWorld* World);
+
+	/** Returns the manager of the world if it has one */
+	static FVerletClothSimulationManager* Find(UWorld* World);
+
+	/** Returns true if new cloth components should be simulated by a manager (verletcloth.UseSimulationManager) */
+	static bool IsEnabled();
+
+	/** Module startup and shutdown, tracks world cleanup */
+	static void OnStartup();
+	static void OnShutdown();
+
+	void AddComponent(UVerletClothComponent* Component);
+	void RemoveComponent(UVerletClothComponent* Component);
+
+	/** Simulates every registered synchronous component */
+	void Tick(float DeltaTime, ELevelTick TickType);
+
+	/** Publishes last frame's async batch and kicks the next one */
+	void TickAsync(float DeltaTime, ELevelTick TickType);
+
+private:
+
+	FVerletClothSimulationManager(UWorld* InWorld);
+	~FVerletClothSimulationManager();
+
+	static void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+
+	/** Collects the components to simulate this frame and their inputs */
+	void GatherComponents(bool bAsync, float DeltaTime, ELevelTick TickType, TArray<UVerletClothComponent*>& OutComponents, TArray<FVerletClothSimulationInput>& OutInputs) const;
+
+	/** World owning the manager */
+	UWorld* World;
+
+	/** Every registered component */
+	TArray<UVerletClothComponent*> Components;
+
+	/** Components simulated this frame and their inputs, kept around to avoid reallocating */
+	TArray<UVerletClothComponent*> TickedComponents;
+	TArray<FVerletClothSimulationInput> TickedInputs;
+
+	/** Async components of the batch in flight and their inputs, only touched by the game thread once the batch completed */
+	TArray<UVerletClothComponent*> AsyncComponents;
+	TArray<FVerletClothSimulationInput> AsyncInputs;
+
+	/** Completion of the async batch in flight */
+	FGraphEventRef AsyncBatchEvent;
+
+	FVerletClothSimulationManagerTickFunction TickFunction;
+	FVerletClothSimulationManagerTickFunction AsyncTickFunction;
+
+	static TMap<UWorld*, FVerletClothSimulationManager*> WorldManagers;
+	static FDelegateHandle OnWorldCleanupHandle;
+};
@@ -0,0 +1,296 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothSnapshot.h"
+
+namespace
+{
+	/** 'VCSN' */
+	const uint32 SnapshotMagic = 0x4E534356;
+	/** Bumped whenever the layout below changes, older snapshots fail to load */
+	const uint32 SnapshotVersion = 1;
+
+	/** 'VCRP' */
+	const uint32 RestPoseMagic = 0x50524356;
+	const uint32 RestPoseVersion = 2;
+
+	/** Every supported platform is little endian, values are written as they are in memory */
+	class FSnapshotWriter
+	{
+	public:
+
+		explicit FSnapshotWriter(TArray<uint8>& InData)
+			: Data(InData)
+		{}
+
+		void Write(const void* Value, int32 Size)
+		{
+			// Added first, adding may move the data
+			const int32 Index = Data.AddUninitialized(Size);
+			FMemory::Memcpy(Data.GetData() + Index, Value, Size);
+		}
+
+		template<typename T>
+		void Write(const T& Value)
+		{
+			Write(&Value, sizeof(T));
+		}
+
+		void Write(const FVector& Value)
+		{
+			Write(Value.X);
+			Write(Value.Y);
+			Write(Value.Z);
+		}
+
+	private:
+
+		TArray<uint8>& Data;
+	};
+
+	class FSnapshotReader
+	{
+	public:
+
+		FSnapshotReader(const TArray<uint8>& InData, int32 InOffset)
+			: Data(InData)
+			, Offset(InOffset)
+			, bError(InOffset < 0)
+		{}
+
+		void Read(void* Value, int32 Size)
+		{
+			if (bError || Size > Data.Num() - Offset)
+			{
+				bError = true;
+				FMemory::Memzero(Value, Size);
+				return;
+			}
+			FMemory::Memcpy(Value, Data.GetData() + Offset, Size);
+			Offset += Size;
+		}
+
+		template<typename T>
+		void Read(T& Value)
+		{
+			Read(&Value, sizeof(T));
+		}
+
+		void Read(FVector& Value)
+		{
+			Read(Value.X);
+			Read(Value.Y);
+			Read(Value.Z);
+		}
+
+		const TArray<uint8>& Data;
+		int32 Offset;
+		bool bError;
+	};
+}
+
+void FVerletClothSnapshot::Capture(const FVerletClothParticles& Particles)
+{
+	NumLines = Particles.NumLines;
+	NumPointsPerLine = Particles.NumPointsPerLine;
+	NumParticles = Particles.NumParticles;
+
+	Positions.SetNumUninitialized(NumParticles * 3);
+	SavedPositions.SetNumUninitialized(NumParticles * 3);
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		FMemory::Memcpy(Positions.GetData() + Axis * NumParticles, Particles.GetStream((FVerletClothParticles::EStream)(FVerletClothParticles::PositionX + Axis)), NumParticles * sizeof(float));
+		FMemory::Memcpy(SavedPositions.GetData() + Axis * NumParticles, Particles.GetStream((FVerletClothParticles::EStream)(FVerletClothParticles::SavedPositionX + Axis)), NumParticles * sizeof(float));
+	}
+
+	Free.SetNumUninitialized(NumParticles);
+	for (int32 Idx = 0; Idx < NumParticles; ++Idx)
+		Free[Idx] = Particles.IsFree(Idx) ? 1 : 0;
+}
+
+bool FVerletClothSnapshot::Restore(FVerletClothParticles& Particles) const
+{
+	if (Particles.NumLines != NumLines || Particles.NumPointsPerLine != NumPointsPerLine || Particles.NumParticles != NumParticles)
+		return false;
+
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		FMemory::Memcpy(Particles.GetStream((FVerletClothParticles::EStream)(FVerletClothParticles::PositionX + Axis)), Positions.GetData() + Axis * NumParticles, NumParticles * sizeof(float));
+		FMemory::Memcpy(Particles.GetStream((FVerletClothParticles::EStream)(FVerletClothParticles::SavedPositionX + Axis)), SavedPositions.GetData() + Axis * NumParticles, NumParticles * sizeof(float));
+	}
+
+	for (int32 Idx = 0; Idx < NumParticles; ++Idx)
+		Particles.SetFree(Idx, Free[Idx] != 0);
+	return true;
+}
+
+void FVerletClothSnapshot::Save(TArray<uint8>& Data) const
+{
+	FSnapshotWriter Writer(Data);
+	Writer.Write(SnapshotMagic);
+	Writer.Write(SnapshotVersion);
+	Writer.Write(Time);
+
+	Writer.Write(Params.SubstepTime);
+	Writer.Write(Params.Settings.SolverIterations);
+	Writer.Write(Params.Settings.SolverTolerance);
+	Writer.Write(Params.Settings.SolverRelaxation);
+	Writer.Write(Params.Settings.Damping);
+	Writer.Write(Params.Gravity);
+	Writer.Write(Params.Wind);
+	Writer.Write(Params.Settings.WindDrag);
+	Writer.Write(Params.Settings.WindLift);
+	Writer.Write((uint8)(Params.Settings.bUseXPBD ? 1 : 0));
+	for (int32 Type = 0; Type < FVerletClothTopology::NumConstraintTypes; ++Type)
+		Writer.Write(Params.Settings.Compliance[Type]);
+	Writer.Write(Params.TetherScale);
+	Writer.Write(Params.Settings.SelfCollisionThickness);
+
+	Writer.Write(NumLines);
+	Writer.Write(NumPointsPerLine);
+	Writer.Write(NumParticles);
+	Writer.Write(Positions.GetData(), NumParticles * 3 * sizeof(float));
+	Writer.Write(SavedPositions.GetData(), NumParticles * 3 * sizeof(float));
+	Writer.Write(Free.GetData(), NumParticles);
+}
+
+bool FVerletClothSnapshot::Load(const TArray<uint8>& Data, int32& Offset)
+{
+	FSnapshotReader Reader(Data, Offset);
+	uint32 Magic, Version;
+	Reader.Read(Magic);
+	Reader.Read(Version);
+	if (Reader.bError || Magic != SnapshotMagic || Version != SnapshotVersion)
+		return false;
+
+	Reader.Read(Time);
+
+	uint8 bUseXPBD;
+	Reader.Read(Params.SubstepTime);
+	Reader.Read(Params.Settings.SolverIterations);
+	Reader.Read(Params.Settings.SolverTolerance);
+	Reader.Read(Params.Settings.SolverRelaxation);
+	Reader.Read(Params.Settings.Damping);
+	Reader.Read(Params.Gravity);
+	Reader.Read(Params.Wind);
+	Reader.Read(Params.Settings.WindDrag);
+	Reader.Read(Params.Settings.WindLift);
+	Reader.Read(bUseXPBD);
+	Params.Settings.bUseXPBD = (bUseXPBD != 0);
+	for (int32 Type = 0; Type < FVerletClothTopology::NumConstraintTypes; ++Type)
+		Reader.Read(Params.Settings.Compliance[Type]);
+	Reader.Read(Params.TetherScale);
+	Reader.Read(Params.Settings.SelfCollisionThickness);
+
+	Reader.Read(NumLines);
+	Reader.Read(NumPointsPerLine);
+	Reader.Read(NumParticles);
+
+	// Sizes are checked before allocating anything for them
+	if (Reader.bError || NumLines < 0 || NumPointsPerLine < 0 || NumParticles < NumLines * NumPointsPerLine || NumParticles > (Data.Num() - Reader.Offset) / (int32)(6 * sizeof(float) + 1))
+		return false;
+
+	Positions.SetNumUninitialized(NumParticles * 3);
+	SavedPositions.SetNumUninitialized(NumParticles * 3);
+	Free.SetNumUninitialized(NumParticles);
+	Reader.Read(Positions.GetData(), NumParticles * 3 * sizeof(float));
+	Reader.Read(SavedPositions.GetData(), NumParticles * 3 * sizeof(float));
+	Reader.Read(Free.GetData(), NumParticles);
+
+	if (Reader.bError)
+		return false;
+
+	Offset = Reader.Offset;
+	return true;
+}
+
+float FVerletClothSnapshot::GetMaxDifference(const FVerletClothSnapshot& Other) const
+{
+	if (NumLines != Other.NumLines || NumPointsPerLine != Other.NumPointsPerLine || NumParticles != Other.NumParticles)
+		return MAX_flt;
+
+	float MaxDistSquared = 0.0f;
+	for (int32 Idx = 0; Idx < NumParticles; ++Idx)
+	{
+		const FVector Position(Positions[Idx], Positions[Idx + NumParticles], Positions[Idx + NumParticles * 2]);
+		const FVector OtherPosition(Other.Positions[Idx], Other.Positions[Idx + NumParticles], Other.Positions[Idx + NumParticles * 2]);
+		MaxDistSquared = FMath::Max(MaxDistSquared, FVector::DistSquared(Position, OtherPosition));
+	}
+	return FMath::Sqrt(MaxDistSquared);
+}
+
+void FVerletClothRestPose::Capture(const TArray<FVector>& InPositions, int32 InNumLines, int32 InNumPointsPerLine)
+{
+	NumLines = InNumLines;
+	NumPointsPerLine = InNumPointsPerLine;
+	NumParticles = InPositions.Num();
+
+	BoundsMin = NumParticles > 0 ? InPositions[0] : FVector::ZeroVector;
+	BoundsMax = BoundsMin;
+	for (const FVector& Position : InPositions)
+	{
+		BoundsMin = FVector(FMath::Min(BoundsMin.X, Position.X), FMath::Min(BoundsMin.Y, Position.Y), FMath::Min(BoundsMin.Z, Position.Z));
+		BoundsMax = FVector(FMath::Max(BoundsMax.X, Position.X), FMath::Max(BoundsMax.Y, Position.Y), FMath::Max(BoundsMax.Z, Position.Z));
+	}
+
+	Positions.SetNumUninitialized(NumParticles * 3);
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		// Flat axes are all at BoundsMin
+		const float Extent = BoundsMax[Axis] - BoundsMin[Axis];
+		const float Scale = Extent > 0.0f ? MAX_uint16 / Extent : 0.0f;
+		uint16* Quantized = Positions.GetData() + Axis * NumParticles;
+		for (int32 Idx = 0; Idx < NumParticles; ++Idx)
+			Quantized[Idx] = (uint16)FMath::Clamp(FMath::RoundToInt((InPositions[Idx][Axis] - BoundsMin[Axis]) * Scale), 0, (int32)MAX_uint16);
+	}
+}
+
+FVector FVerletClothRestPose::GetPosition(int32 Idx) const
+{
+	const FVector Alpha(Positions[Idx], Positions[Idx + NumParticles], Positions[Idx + NumParticles * 2]);
+	return BoundsMin + (BoundsMax - BoundsMin) * Alpha / (float)MAX_uint16;
+}
+
+void FVerletClothRestPose::Save(TArray<uint8>& Data) const
+{
+	FSnapshotWriter Writer(Data);
+	Writer.Write(RestPoseMagic);
+	Writer.Write(RestPoseVersion);
+	Writer.Write(NumLines);
+	Writer.Write(NumPointsPerLine);
+	Writer.Write(NumParticles);
+	Writer.Write(TopologyHash);
+	Writer.Write(BoundsMin);
+	Writer.Write(BoundsMax);
+	Writer.Write(Positions.GetData(), NumParticles * 3 * sizeof(uint16));
+}
+
+bool FVerletClothRestPose::Load(const TArray<uint8>& Data, int32& Offset)
+{
+	FSnapshotReader Reader(Data, Offset);
+	uint32 Magic, Version;
+	Reader.Read(Magic);
+	Reader.Read(Version);
+	if (Reader.bError || Magic != RestPoseMagic || Version != RestPoseVersion)
+		return false;
+
+	Reader.Read(NumLines);
+	Reader.Read(NumPointsPerLine);
+	Reader.Read(NumParticles);
+	Reader.Read(TopologyHash);
+	Reader.Read(BoundsMin);
+	Reader.Read(BoundsMax);
+
+	// Sizes are checked before allocating anything for them
+	if (Reader.bError || NumLines < 0 || NumPointsPerLine < 0 || NumParticles < NumLines * NumPointsPerLine || NumParticles > (Data.Num() - Reader.Offset) / (int32)(3 * sizeof(uint16)))
+		return false;
+
+	Positions.SetNumUninitialized(NumParticles * 3);
+	Reader.Read(Positions.GetData(), NumParticles * 3 * sizeof(uint16));
+
+	if (Reader.bError)
+		return false;
+
+	Offset = Reader.Offset;
+	return true;
+}
@@ -0,0 +1,293 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothSolver.h"
+#include "VerletClothStats.h"
+#include "VerletClothWindField.h"
+#include "ParallelFor.h"
+
+FVerletClothSolver::FVerletClothSolver(FVerletClothParticles& InParticles, FVerletClothTopology& InTopology, TArray<FVerletClothConstraintBatch>& InBatches,
+	const TArray<uint8>& InBatchTypes, const FVerletClothConstraintBatch& InTethers)
+	: Particles(InParticles)
+	, Topology(InTopology)
+	, Batches(InBatches)
+	, BatchTypes(InBatchTypes)
+	, Tethers(InTethers)
+	, SubstepBounds(0)
+	, SubstepPadding(0.0f)
+	, MaxCorrection(0.0f)
+	, RMSCorrection(0.0f)
+	, IterationsRun(0)
+{}
+
+int32 FVerletClothSolver::GetFrameSubsteps(float DeltaTime, float TimeDilation, float SubstepRate, int32 MaxSubsteps, int32 DeterministicSubsteps, float& InOutAccumulatedTime, float& OutTimeStep)
+{
+	OutTimeStep = (DeterministicSubsteps > 0 ? 1.0f : TimeDilation) / FMath::Max(SubstepRate, 1.0f);
+	if (OutTimeStep <= 0.0f)
+		return 0;
+
+	// Leftover time is carried to the next frame
+	InOutAccumulatedTime += DeltaTime;
+	int32 NumSubsteps = FMath::FloorToInt(InOutAccumulatedTime / OutTimeStep);
+	if (DeterministicSubsteps > 0)
+	{
+		// Same substeps every frame, nothing carried over
+		NumSubsteps = DeterministicSubsteps;
+		InOutAccumulatedTime = NumSubsteps * OutTimeStep;
+	}
+	else if (MaxSubsteps > 0 && NumSubsteps > MaxSubsteps)
+	{
+		// Over budget, the cloth slows down for a frame instead of making the next one longer too
+		NumSubsteps = MaxSubsteps;
+		InOutAccumulatedTime = NumSubsteps * OutTimeStep + FMath::Fmod(InOutAccumulatedTime, OutTimeStep);
+	}
+
+	InOutAccumulatedTime -= NumSubsteps * OutTimeStep;
+	return NumSubsteps;
+}
+
+void FVerletClothSolver::Substep(const FVerletClothSimulationSettings& Settings, const FVerletClothSubstepInput& Input)
+{
+	UpdateAcceleration(Settings, Input);
+	Integrate(Settings, Input);
+	SolveConstraints(Settings, Input.TimeStep);
+	SolveTethers();
+	if (Settings.SelfCollisionThickness > 0.0f)
+		SolveSelfCollision(Settings.SelfCollisionThickness);
+	ProcessCollision(Input);
+}
+
+void FVerletClothSolver::UpdateAcceleration(const FVerletClothSimulationSettings& Settings, const FVerletClothSubstepInput& Input)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_Forces);
+
+	VerletClothKernels::SetAcceleration(Particles, Input.Gravity);
+
+	// No air resistance without wind either
+	if (Input.WindField == NULL)
+		return;
+
+	const int32 Stride = Particles.StreamStride;
+	WindSamples.SetNumUninitialized(Stride * 3);
+	float* WindX = WindSamples.GetData();
+	float* WindY = WindX + Stride;
+	float* WindZ = WindY + Stride;
+	Input.WindField->SampleWind(Particles.GetStream(FVerletClothParticles::PositionX), Particles.GetStream(FVerletClothParticles::PositionY), Particles.GetStream(FVerletClothParticles::PositionZ),
+		Particles.NumParticles, Input.Time, WindX, WindY, WindZ);
+
+	const int32 NumTriangles = Topology.TriangleCorners[0].Num();
+	TriangleForces.SetNumUninitialized(NumTriangles * 3);
+	float* ForceX = TriangleForces.GetData();
+	float* ForceY = ForceX + NumTriangles;
+	float* ForceZ = ForceY + NumTriangles;
+	VerletClothKernels::ComputeAerodynamicForces(Particles, Topology.TriangleCorners[0].GetData(), Topology.TriangleCorners[1].GetData(), Topology.TriangleCorners[2].GetData(), NumTriangles,
+		WindX, WindY, WindZ, Input.TimeStep, Settings.WindDrag, Settings.WindLift, ForceX, ForceY, ForceZ);
+
+	// Every particle gets the forces of its triangles, averaged over them
+	float* AccX = Particles.GetStream(FVerletClothParticles::AccelerationX);
+	float* AccY = Particles.GetStream(FVerletClothParticles::AccelerationY);
+	float* AccZ = Particles.GetStream(FVerletClothParticles::AccelerationZ);
+	const float* InvTriangleCounts = Topology.InvTriangleCounts.GetData();
+	for (int32 Corner = 0; Corner < 3; ++Corner)
+	{
+		const int32* Corners = Topology.TriangleCorners[Corner].GetData();
+		for (int32 TriangleIdx = 0; TriangleIdx < NumTriangles; ++TriangleIdx)
+		{
+			const int32 Idx = Corners[TriangleIdx];
+			AccX[Idx] += ForceX[TriangleIdx] * InvTriangleCounts[Idx];
+			AccY[Idx] += ForceY[TriangleIdx] * InvTriangleCounts[Idx];
+			AccZ[Idx] += ForceZ[TriangleIdx] * InvTriangleCounts[Idx];
+		}
+	}
+}
+
+void FVerletClothSolver::Integrate(const FVerletClothSimulationSettings& Settings, const FVerletClothSubstepInput& Input)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_Integrate);
+
+	float MaxSquaredStep;
+	SubstepBounds = VerletClothKernels::Integrate(Particles, 1.0f - Settings.Damping, Input.TimeStep * Input.TimeStep, MaxSquaredStep);
+	float MaxPinnedStep = 0.0f;
+
+	// Pinned mesh particles are held in place, pinned grid lines keep their saved offset
+	if (Input.PinnedPositions)
+	{
+		for (int32 PinnedIdx = 0; PinnedIdx < Topology.PinnedParticles.Num(); ++PinnedIdx)
+		{
+			const int32 Idx = Topology.PinnedParticles[PinnedIdx];
+			const FVector& Position = Input.PinnedPositions[PinnedIdx];
+			MaxPinnedStep = FMath::Max(MaxPinnedStep, FVector::Dist(Particles.GetPosition(Idx), Position));
+			Particles.SetPosition(Idx, Position);
+			SubstepBounds += Position;
+		}
+	}
+
+	for (int32 LineIdx = 0; LineIdx < Input.NumPinnedLines; LineIdx++)
+	{
+		// Lines move as a whole
+		const FVector OldStart = Particles.GetPosition(Particles.GetIndex(LineIdx, 0));
+		VerletClothKernels::ProcessPinnedLine(Particles, LineIdx, Input.PinnedLineStart, Input.PinnedLineDelta);
+		MaxPinnedStep = FMath::Max(MaxPinnedStep, FVector::Dist(OldStart, Particles.GetPosition(Particles.GetIndex(LineIdx, 0))));
+		for (int32 PointIdx = 0; PointIdx < Particles.NumPointsPerLine; ++PointIdx)
+			SubstepBounds += Particles.GetPosition(Particles.GetIndex(LineIdx, PointIdx));
+	}
+
+	// Constraints take back at most the stretch the steps of both of their particles made, self collision pushes by the thickness
+	SubstepPadding = 2.0f * FMath::Max(FMath::Sqrt(MaxSquaredStep), MaxPinnedStep) + Settings.SelfCollisionThickness;
+}
+
+void FVerletClothSolver::SolveConstraints(const FVerletClothSimulationSettings& Settings, float TimeStep)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_SolveConstraints);
+
+	// Compliances are scaled by the substep so the same compliance gives the same stiffness at any substep rate
+	float Alphas[FVerletClothTopology::NumConstraintTypes];
+	const float InvTimeStepSquared = Settings.bUseXPBD ? 1.0f / FMath::Max(TimeStep * TimeStep, SMALL_NUMBER) : 0.0f;
+	for (int32 Type = 0; Type < FVerletClothTopology::NumConstraintTypes; ++Type)
+		Alphas[Type] = Settings.Compliance[Type] * InvTimeStepSquared;
+
+	if (Settings.bParallelSolver)
+	{
+		SolveConstraintBatches(Settings, Alphas);
+		return;
+	}
+
+	// Sorted by type then by particle, every sweep walks the streams in order
+	FVerletClothConstraintBatch& Constraints = Topology.Constraints;
+	if (Settings.bUseXPBD)
+		Constraints.ResetLambda();
+
+	VerletClothKernels::FResidual Residual;
+	int32 IterationIdx = 0;
+	while (IterationIdx < Settings.SolverIterations)
+	{
+		Residual = VerletClothKernels::FResidual();
+		for (int32 ConstraintIdx = 0; ConstraintIdx < Constraints.Num(); ++ConstraintIdx)
+		{
+			const int32 IdxA = Constraints.IndexA[ConstraintIdx];
+			const int32 IdxB = Constraints.IndexB[ConstraintIdx];
+			if (Settings.bUseXPBD)
+			{
+				const float Alpha = Alphas[Topology.ConstraintTypes[ConstraintIdx]];
+				Residual.Add(Particles.SolveCompliantConstraint(IdxA, IdxB, Constraints.RestLength[ConstraintIdx], Alpha, Settings.SolverRelaxation, Constraints.Lambda[ConstraintIdx]));
+			}
+			else
+			{
+				Residual.Add(Particles.SolvePositionConstraint(IdxA, IdxB, Constraints.RestLength[ConstraintIdx], Settings.SolverRelaxation));
+			}
+		}
+
+		IterationIdx++;
+		if (Residual.MaxCorrection <= Settings.SolverTolerance)
+			break;
+	}
+
+	SetResidual(Residual, IterationIdx);
+}
+
+void FVerletClothSolver::SolveConstraintBatches(const FVerletClothSimulationSettings& Settings, const float* Alphas)
+{
+	const int32 ChunkSize = Settings.ParallelBatchSize;
+
+	if (Settings.bUseXPBD)
+	{
+		for (FVerletClothConstraintBatch& Batch : Batches)
+			Batch.ResetLambda();
+	}
+
+	// Every chunk measures its own residual, they are merged once the batch is done
+	VerletClothKernels::FResidual Residual;
+	int32 IterationIdx = 0;
+	while (IterationIdx < Settings.SolverIterations)
+	{
+		Residual = VerletClothKernels::FResidual();
+		for (int32 BatchIdx = 0; BatchIdx < Batches.Num(); BatchIdx++)
+		{
+			FVerletClothConstraintBatch& Batch = Batches[BatchIdx];
+			const float Alpha = Alphas[BatchTypes[BatchIdx]];
+			const int32 NumChunks = FMath::DivideAndRoundUp(Batch.Num(), ChunkSize);
+			ChunkResiduals.Reset();
+			ChunkResiduals.AddDefaulted(NumChunks);
+			ParallelFor(NumChunks, [&](int32 ChunkIdx)
+			{
+				const int32 Start = ChunkIdx * ChunkSize;
+				const int32 Num = FMath::Min(ChunkSize, Batch.Num() - Start);
+				if (Settings.bUseXPBD)
+					ChunkResiduals[ChunkIdx] = VerletClothKernels::SolveCompliantDistanceConstraints(Particles, &Batch.IndexA[Start], &Batch.IndexB[Start], &Batch.RestLength[Start], &Batch.Lambda[Start], Alpha, Num, Settings.SolverRelaxation);
+				else
+					ChunkResiduals[ChunkIdx] = VerletClothKernels::SolveDistanceConstraints(Particles, &Batch.IndexA[Start], &Batch.IndexB[Start], &Batch.RestLength[Start], Num, Settings.SolverRelaxation);
+			}, NumChunks == 1);
+
+			for (const VerletClothKernels::FResidual& ChunkResidual : ChunkResiduals)
+				Residual.Add(ChunkResidual);
+		}
+
+		IterationIdx++;
+		if (Residual.MaxCorrection <= Settings.SolverTolerance)
+			break;
+	}
+
+	SetResidual(Residual, IterationIdx);
+}
+
+void FVerletClothSolver::SolveTethers()
+{
+	// One pass is enough, anchors are pinned so every tether only moves its own free particle.
+	// Tethers sharing an anchor write it back unchanged.
+	if (Tethers.Num() > 0)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_VerletCloth_SolveTethers);
+		VerletClothKernels::SolveDistanceConstraints(Particles, Tethers.IndexA.GetData(), Tethers.IndexB.GetData(), Tethers.RestLength.GetData(), Tethers.Num(), 1.0f);
+	}
+}
+
+void FVerletClothSolver::SolveSelfCollision(float Thickness)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_SelfCollision);
+	SelfCollision.Solve(Particles, Thickness, Topology.RestPositions);
+}
+
+void FVerletClothSolver::ProcessCollision(const FVerletClothSubstepInput& Input)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VerletCloth_Collision);
+
+	if (Input.bCollisionPlane)
+		VerletClothKernels::ProjectPlane(Particles, Input.CollisionPlane);
+
+	if (Input.NumColliders == 0 || !SubstepBounds.IsValid)
+		return;
+
+	// Broadphase, only shapes touching the cloth are processed. Its bounds come from the integration, grown by how far it moved since.
+	const FBox ClothBounds = SubstepBounds.ExpandBy(SubstepPadding);
+	for (int32 ColliderIdx = 0; ColliderIdx < Input.NumColliders; ++ColliderIdx)
+	{
+		const FVerletClothCollider& Collider = Input.Colliders[ColliderIdx];
+		if (!ClothBounds.Intersect(Collider.Bounds))
+			continue;
+
+		if (Collider.bBox)
+			VerletClothKernels::CollideBox(Particles, Collider.Start, Collider.Rotation, Collider.Extent);
+		else
+			VerletClothKernels::CollideCapsule(Particles, Collider.Start, Collider.End, Collider.Radius);
+	}
+}
+
+void FVerletClothSolver::GetResidual(float& OutMaxCorrection, float& OutRMSCorrection, int32& OutIterationsRun) const
+{
+	OutMaxCorrection = MaxCorrection;
+	OutRMSCorrection = RMSCorrection;
+	OutIterationsRun = IterationsRun;
+}
+
+uint32 FVerletClothSolver::GetAllocatedSize() const
+{
+	return WindSamples.GetAllocatedSize() + TriangleForces.GetAllocatedSize() + ChunkResiduals.GetAllocatedSize() + SelfCollision.GetAllocatedSize();
+}
+
+void FVerletClothSolver::SetResidual(const VerletClothKernels::FResidual& Residual, int32 NumIterations)
+{
+	MaxCorrection = Residual.MaxCorrection;
+	RMSCorrection = FMath::Sqrt(Residual.SumSquaredCorrection / FMath::Max(Topology.Constraints.Num(), 1));
+	IterationsRun = NumIterations;
+	INC_DWORD_STAT_BY(STAT_VerletCloth_SolverIterations, NumIterations);
+}
@@ -0,0 +1,110 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "VerletClothKernels.h"
+#include "VerletClothSelfCollision.h"
+
+class FVerletClothWindField;
+
+/** What a substep reads besides the cloth and its settings, in simulation space */
+struct FVerletClothSubstepInput
+{
+	FVerletClothSubstepInput()
+	: TimeStep(0.0f), Time(0.0f), Gravity(FVector::ZeroVector), WindField(NULL)
+	, bCollisionPlane(false), CollisionPlane(0.0f, 0.0f, 1.0f, 0.0f), Colliders(NULL), NumColliders(0)
+	, NumPinnedLines(0), PinnedLineStart(FVector::ZeroVector), PinnedLineDelta(FVector::ZeroVector), PinnedPositions(NULL)
+	{}
+
+	float TimeStep;
+	/** Simulated time at the start of the substep, the wind is sampled then */
+	float Time;
+	FVector Gravity;
+	/** Wind blowing on the cloth in simulation space, NULL for no wind and no air resistance either */
+	const FVerletClothWindField* WindField;
+	/** Free particles behind the plane are pushed back onto it */
+	bool bCollisionPlane;
+	FPlane CollisionPlane;
+	const FVerletClothCollider* Colliders;
+	int32 NumColliders;
+	/** The first lines of a grid are held at PinnedLineStart + PinnedLineDelta * PointIdx from their saved position */
+	int32 NumPinnedLines;
+	FVector PinnedLineStart;
+	FVector PinnedLineDelta;
+	/** Where the pinned particles of a mesh are held, one for each of Topology.PinnedParticles */
+	const FVector* PinnedPositions;
+};
+
+/**
+ * Runs the substeps of a cloth, the component and the standalone harnesses share it so they simulate the same way:
+ * forces, integration, pinned particles, constraints, tethers, self collision then collision.
+ * Works on the particles and constraints it is created with, which must outlive it, and keeps the scratch buffers
+ * of the substeps and the residual of the last solve. Only touches the cloth, so it runs on any thread.
+ */
+class FVerletClothSolver
+{
+public:
+
+	FVerletClothSolver(FVerletClothParticles& InParticles, FVerletClothTopology& InTopology, TArray<FVerletClothConstraintBatch>& InBatches,
+		const TArray<uint8>& InBatchTypes, const FVerletClothConstraintBatch& InTethers);
+
+	/**
+	 * Number of substeps of a frame of DeltaTime and their length, 0 if the substep rate gives none.
+	 * Time left over is carried to the next frame in InOutAccumulatedTime. Over MaxSubsteps, when not 0, the extra time is dropped.
+	 * Deterministic frames run DeterministicSubsteps substeps of one over the substep rate, whatever the frame time and time dilation.
+	 */
+	static int32 GetFrameSubsteps(float DeltaTime, float TimeDilation, float SubstepRate, int32 MaxSubsteps, int32 DeterministicSubsteps, float& InOutAccumulatedTime, float& OutTimeStep);
+
+	/** Simulates one substep */
+	void Substep(const FVerletClothSimulationSettings& Settings, const FVerletClothSubstepInput& Input);
+
+	/** Gravity and aerodynamic forces of every particle */
+	void UpdateAcceleration(const FVerletClothSimulationSettings& Settings, const FVerletClothSubstepInput& Input);
+
+	/** Verlet step of the free particles, then the pinned ones are moved where they are held. Gathers the bounds of the collision broadphase on the way. */
+	void Integrate(const FVerletClothSimulationSettings& Settings, const FVerletClothSubstepInput& Input);
+
+	/** Solver iterations over the topology constraints, sequentially or batch by batch, until they converge within the tolerance */
+	void SolveConstraints(const FVerletClothSimulationSettings& Settings, float TimeStep);
+
+	void SolveTethers();
+
+	void SolveSelfCollision(float Thickness);
+
+	void ProcessCollision(const FVerletClothSubstepInput& Input);
+
+	/** Largest and RMS constraint correction of the last solver sweep, and the sweeps the last solve ran */
+	void GetResidual(float& OutMaxCorrection, float& OutRMSCorrection, int32& OutIterationsRun) const;
+
+	/** Memory held by the scratch buffers */
+	uint32 GetAllocatedSize() const;
+
+private:
+
+	void SolveConstraintBatches(const FVerletClothSimulationSettings& Settings, const float* Alphas);
+
+	void SetResidual(const VerletClothKernels::FResidual& Residual, int32 NumIterations);
+
+	FVerletClothParticles& Particles;
+	FVerletClothTopology& Topology;
+	TArray<FVerletClothConstraintBatch>& Batches;
+	const TArray<uint8>& BatchTypes;
+	const FVerletClothConstraintBatch& Tethers;
+
+	/** Wind at every particle then aerodynamic force on every triangle, stream after stream, reused every substep */
+	TArray<float> WindSamples;
+	TArray<float> TriangleForces;
+
+	/** Residual of every chunk of a batch, merged once the batch is done */
+	TArray<VerletClothKernels::FResidual, TInlineAllocator<16>> ChunkResiduals;
+
+	FVerletClothSelfCollision SelfCollision;
+
+	/** Bounds of the particles once integrated and how far the rest of the substep may move them, for the collision broadphase */
+	FBox SubstepBounds;
+	float SubstepPadding;
+
+	float MaxCorrection;
+	float RMSCorrection;
+	int32 IterationsRun;
+};
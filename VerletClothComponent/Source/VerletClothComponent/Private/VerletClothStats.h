@@ -0,0 +1,49 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+/**
+ * Stats of the cloth components, shown with "stat VerletCloth".
+ * Cycle stats also show up as named events on timeline profilers with "stat NamedEvents".
+ * Counters are cleared every frame, memory stats are kept up to date as buffers grow and go away.
+ */
+DECLARE_STATS_GROUP(TEXT("Verlet Cloth"), STATGROUP_VerletCloth, STATCAT_Advanced);
+
+// Game thread
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Manager Tick"), STAT_VerletCloth_ManagerTick, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Gather Input"), STAT_VerletCloth_GatherInput, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update LOD"), STAT_VerletCloth_UpdateLOD, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tearing"), STAT_VerletCloth_Tearing, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Topology"), STAT_VerletCloth_BuildTopology, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Solver Batches"), STAT_VerletCloth_BuildSolverBatches, STATGROUP_VerletCloth, );
+
+// Simulation, on worker threads when simulated by the manager or in async mode
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Async Simulation Task"), STAT_VerletCloth_AsyncTask, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Simulate"), STAT_VerletCloth_Simulate, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integrate"), STAT_VerletCloth_Integrate, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Forces"), STAT_VerletCloth_Forces, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Solve Constraints"), STAT_VerletCloth_SolveConstraints, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Solve Tethers"), STAT_VerletCloth_SolveTethers, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Self Collision"), STAT_VerletCloth_SelfCollision, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Collision"), STAT_VerletCloth_Collision, STATGROUP_VerletCloth, );
+
+// Rendering
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pack Dynamic Data"), STAT_VerletCloth_PackDynamicData, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Tangents"), STAT_VerletCloth_BuildTangents, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Static Mesh"), STAT_VerletCloth_BuildStaticMesh, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GPU Upload"), STAT_VerletCloth_Upload, STATGROUP_VerletCloth, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Get Dynamic Mesh Elements"), STAT_VerletCloth_GetDynamicMeshElements, STATGROUP_VerletCloth, );
+
+// Counters
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Simulated Components"), STAT_VerletCloth_SimulatedComponents, STATGROUP_VerletCloth, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Sleeping Components"), STAT_VerletCloth_SleepingComponents, STATGROUP_VerletCloth, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Throttled Components"), STAT_VerletCloth_ThrottledComponents, STATGROUP_VerletCloth, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Simulated Particles"), STAT_VerletCloth_Particles, STATGROUP_VerletCloth, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Simulated Constraints"), STAT_VerletCloth_Constraints, STATGROUP_VerletCloth, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Substeps"), STAT_VerletCloth_Substeps, STATGROUP_VerletCloth, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Solver Iterations"), STAT_VerletCloth_SolverIterations, STATGROUP_VerletCloth, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes Uploaded"), STAT_VerletCloth_BytesUploaded, STATGROUP_VerletCloth, );
+
+// Memory
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Simulation Memory"), STAT_VerletCloth_SimulationMemory, STATGROUP_VerletCloth, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Proxy Buffer Memory"), STAT_VerletCloth_ProxyMemory, STATGROUP_VerletCloth, );
@@ -0,0 +1,557 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#include "VerletClothComponentPluginPrivatePCH.h"
+
+#if !VERLETCLOTH_STANDALONE
+#include "StaticMeshResources.h"
+#endif
+
+void FVerletClothTopology::Reset()
+{
+	bGrid = true;
+	bTorn = false;
+	NumParticles = 0;
+	MaxParticles = 0;
+	MaxRenderVertices = 0;
+	RestPositions.Reset();
+	Pinned.Reset();
+	PinnedParticles.Reset();
+	Constraints = FVerletClothConstraintBatch();
+	ConstraintTypes.Reset();
+	Triangles.Reset();
+	for (int32 Corner = 0; Corner < 3; ++Corner)
+		TriangleCorners[Corner].Reset();
+	InvTriangleCounts.Reset();
+	RenderParticles.Reset();
+	RenderUVs.Reset();
+	RenderColors.Reset();
+	RenderIndices.Reset();
+}
+
+void FVerletClothTopology::BuildGrid(int32 NumLines, int32 NumPoints, int32 NumFixedLines, float Length, float Width, bool bRenderMesh)
+{
+	bGrid = true;
+	bTorn = false;
+	NumParticles = NumLines * NumPoints;
+
+	// Flat rest shape, it only gives the rest lengths
+	const float SegmentLength = Length / (float)(NumLines - 1);
+	const float HorizontalLength = Width / (float)(NumPoints - 1);
+	RestPositions.SetNumUninitialized(NumParticles);
+	Pinned.SetNumUninitialized(NumParticles);
+	for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+	{
+		for (int32 PointIdx = 0; PointIdx < NumPoints; PointIdx++)
+		{
+			const int32 Idx = LineIdx * NumPoints + PointIdx;
+			RestPositions[Idx] = FVector(PointIdx * HorizontalLength, LineIdx * SegmentLength, 0.0f);
+			Pinned[Idx] = (LineIdx < NumFixedLines);
+		}
+	}
+
+	Constraints = FVerletClothConstraintBatch();
+	ConstraintTypes.Reset();
+	Triangles.Reset();
+	for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+	{
+		const int32 LineA = LineIdx * NumPoints;
+		for (int32 Idx = 0; Idx < NumPoints - 1; ++Idx)
+			AddConstraint(LineA + Idx, LineA + Idx + 1, Structural);
+
+		if (LineIdx == NumLines - 1)
+			continue;
+
+		const int32 LineB = LineA + NumPoints;
+		for (int32 Idx = 0; Idx < NumPoints; ++Idx)
+			AddConstraint(LineA + Idx, LineB + Idx, Structural);
+
+		for (int32 Idx = 0; Idx < NumPoints - 1; ++Idx)
+		{
+			AddConstraint(LineA + Idx, LineB + Idx + 1, Shear);
+			AddConstraint(LineA + Idx + 1, LineB + Idx, Shear);
+			AddTriangle(LineA + Idx, LineB + Idx, LineA + Idx + 1);
+			AddTriangle(LineA + Idx + 1, LineB + Idx, LineB + Idx + 1);
+		}
+	}
+
+	RenderParticles.Reset();
+	RenderUVs.Reset();
+	RenderColors.Reset();
+	RenderIndices.Reset();
+	if (bRenderMesh)
+	{
+		// Same UVs as the full resolution grid of the proxy
+		for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+		{
+			for (int32 PointIdx = 0; PointIdx < NumPoints; PointIdx++)
+			{
+				RenderParticles.Add(LineIdx * NumPoints + PointIdx);
+				RenderUVs.Add(FVector2D((float)PointIdx / (float)(NumPoints - 1), (float)LineIdx / (float)(NumLines - 1)));
+				RenderColors.Add(FColor::White);
+			}
+		}
+		for (int32 Idx : Triangles)
+			RenderIndices.Add(Idx);
+	}
+
+	Finish();
+}
+
+#if !VERLETCLOTH_STANDALONE
+bool FVerletClothTopology::BuildFromMesh(const UStaticMesh* Mesh)
+{
+	// A failed build leaves a grid topology to rebuild
+	Reset();
+	if (Mesh == NULL || Mesh->RenderData == NULL || Mesh->RenderData->LODResources.Num() == 0)
+		return false;
+
+#if !WITH_EDITOR
+	// Cooked vertex and index buffers only keep a CPU copy when the mesh asks for it
+	if (!Mesh->bAllowCPUAccess)
+	{
+		UE_LOG(LogVerletCloth, Warning, TEXT("Cloth mesh %s needs Allow CPU Access to be simulated in a cooked build"), *Mesh->GetName());
+		return false;
+	}
+#endif
+
+	const FStaticMeshLODResources& LOD = Mesh->RenderData->LODResources[0];
+	const int32 NumVerts = LOD.GetNumVertices();
+	const FIndexArrayView Indices = LOD.IndexBuffer.GetArrayView();
+	if (NumVerts == 0 || Indices.Num() < 3 || LOD.PositionVertexBuffer.GetNumVertices() != NumVerts)
+		return false;
+
+	NumParticles = 0;
+	RestPositions.Reset();
+	Pinned.Reset();
+	RenderParticles.Init(INDEX_NONE, NumVerts);
+	RenderUVs.SetNumUninitialized(NumVerts);
+	RenderColors.SetNumUninitialized(NumVerts);
+	RenderIndices.Reset();
+
+	const bool bHasUVs = LOD.VertexBuffer.GetNumTexCoords() > 0;
+	const bool bHasColors = LOD.ColorVertexBuffer.GetNumVertices() == NumVerts;
+
+	// Vertices split along UV or normal seams share a position and become one particle
+	TMap<FVector, int32> WeldedParticles;
+	auto AddVertex = [&](int32 VertIdx)
+	{
+		if (RenderParticles[VertIdx] != INDEX_NONE)
+			return;
+
+		const FVector Position = LOD.PositionVertexBuffer.VertexPosition(VertIdx);
+		int32* ParticleIdx = WeldedParticles.Find(Position);
+		if (ParticleIdx == NULL)
+		{
+			ParticleIdx = &WeldedParticles.Add(Position, NumParticles++);
+			RestPositions.Add(Position);
+			Pinned.Add(false);
+		}
+
+		const FColor Color = bHasColors ? LOD.ColorVertexBuffer.VertexColor(VertIdx) : FColor::White;
+		RenderParticles[VertIdx] = *ParticleIdx;
+		RenderUVs[VertIdx] = bHasUVs ? LOD.VertexBuffer.GetVertexUV(VertIdx, 0) : FVector2D::ZeroVector;
+		RenderColors[VertIdx] = Color;
+		if (bHasColors && Color.R > 127)
+			Pinned[*ParticleIdx] = true;
+	};
+
+	// First use in the index buffer, which is already ordered for the vertex cache
+	for (int32 Idx = 0; Idx < Indices.Num(); ++Idx)
+		AddVertex(Indices[Idx]);
+	for (int32 VertIdx = 0; VertIdx < NumVerts; ++VertIdx)
+		AddVertex(VertIdx);
+
+	Constraints = FVerletClothConstraintBatch();
+	ConstraintTypes.Reset();
+	Triangles.Reset();
+
+	// Every edge once, and a bending constraint between the far corners of the first two triangles on it.
+	// Degenerate triangles are not rendered either, so rendered and particle triangles match for tearing.
+	TMap<uint64, int32> EdgeOppositeParticles;
+	for (int32 Idx = 0; Idx + 2 < Indices.Num(); Idx += 3)
+	{
+		const int32 Corners[3] = { RenderParticles[Indices[Idx]], RenderParticles[Indices[Idx + 1]], RenderParticles[Indices[Idx + 2]] };
+		if (Corners[0] == Corners[1] || Corners[1] == Corners[2] || Corners[2] == Corners[0])
+			continue;
+
+		AddTriangle(Corners[0], Corners[1], Corners[2]);
+		RenderIndices.Add(Indices[Idx]);
+		RenderIndices.Add(Indices[Idx + 1]);
+		RenderIndices.Add(Indices[Idx + 2]);
+		for (int32 EdgeIdx = 0; EdgeIdx < 3; ++EdgeIdx)
+		{
+			const int32 IdxA = FMath::Min(Corners[EdgeIdx], Corners[(EdgeIdx + 1) % 3]);
+			const int32 IdxB = FMath::Max(Corners[EdgeIdx], Corners[(EdgeIdx + 1) % 3]);
+			const int32 Opposite = Corners[(EdgeIdx + 2) % 3];
+			const uint64 EdgeKey = ((uint64)IdxA << 32) | (uint64)IdxB;
+
+			if (const int32* OtherOpposite = EdgeOppositeParticles.Find(EdgeKey))
+			{
+				if (*OtherOpposite != INDEX_NONE && *OtherOpposite != Opposite)
+					AddConstraint(*OtherOpposite, Opposite, Bend);
+				EdgeOppositeParticles.Add(EdgeKey, INDEX_NONE);
+			}
+			else
+			{
+				AddConstraint(IdxA, IdxB, Structural);
+				EdgeOppositeParticles.Add(EdgeKey, Opposite);
+			}
+		}
+	}
+
+	if (Triangles.Num() == 0)
+		return false;
+
+	bGrid = false;
+	Finish();
+	return true;
+}
+#endif
+
+void FVerletClothTopology::BuildBatches(TArray<FVerletClothConstraintBatch>& OutBatches, TArray<uint8>& OutBatchTypes, int32 NullIdx) const
+{
+	OutBatches.Reset();
+	OutBatchTypes.Reset();
+
+	// Greedy coloring, each constraint goes to the first batch of its type where both particles are still unused.
+	// Constraints come sorted, so every batch is sorted too.
+	TArray<TBitArray<>> UsedParticles;
+	int32 TypeFirstBatch = 0;
+	for (int32 ConstraintIdx = 0; ConstraintIdx < Constraints.Num(); ++ConstraintIdx)
+	{
+		if (ConstraintIdx > 0 && ConstraintTypes[ConstraintIdx] != ConstraintTypes[ConstraintIdx - 1])
+			TypeFirstBatch = OutBatches.Num();
+
+		const int32 IdxA = Constraints.IndexA[ConstraintIdx];
+		const int32 IdxB = Constraints.IndexB[ConstraintIdx];
+		int32 BatchIdx = TypeFirstBatch;
+		while (BatchIdx < OutBatches.Num() && (UsedParticles[BatchIdx][IdxA] || UsedParticles[BatchIdx][IdxB]))
+			BatchIdx++;
+
+		if (BatchIdx == OutBatches.Num())
+		{
+			OutBatches.AddDefaulted();
+			OutBatchTypes.Add(ConstraintTypes[ConstraintIdx]);
+			UsedParticles.Add(TBitArray<>(false, NumParticles));
+		}
+
+		OutBatches[BatchIdx].Add(IdxA, IdxB, Constraints.RestLength[ConstraintIdx]);
+		UsedParticles[BatchIdx][IdxA] = true;
+		UsedParticles[BatchIdx][IdxB] = true;
+	}
+
+	for (FVerletClothConstraintBatch& Batch : OutBatches)
+		Batch.Pad(NullIdx);
+}
+
+void FVerletClothTopology::BuildTethers(FVerletClothConstraintBatch& OutTethers, float Scale, int32 NullIdx) const
+{
+	OutTethers = FVerletClothConstraintBatch();
+	if (PinnedParticles.Num() == 0)
+		return;
+
+	// Edges along the cloth surface, bending constraints cut across folds
+	TArray<int32> EdgeOffsets;
+	EdgeOffsets.AddZeroed(NumParticles + 1);
+	for (int32 ConstraintIdx = 0; ConstraintIdx < Constraints.Num(); ++ConstraintIdx)
+	{
+		if (ConstraintTypes[ConstraintIdx] == Bend)
+			continue;
+		EdgeOffsets[Constraints.IndexA[ConstraintIdx] + 1]++;
+		EdgeOffsets[Constraints.IndexB[ConstraintIdx] + 1]++;
+	}
+	for (int32 Idx = 0; Idx < NumParticles; ++Idx)
+		EdgeOffsets[Idx + 1] += EdgeOffsets[Idx];
+
+	TArray<int32> EdgeParticles;
+	TArray<float> EdgeLengths;
+	TArray<int32> EdgeCounts;
+	EdgeParticles.AddUninitialized(EdgeOffsets[NumParticles]);
+	EdgeLengths.AddUninitialized(EdgeOffsets[NumParticles]);
+	EdgeCounts.AddZeroed(NumParticles);
+	for (int32 ConstraintIdx = 0; ConstraintIdx < Constraints.Num(); ++ConstraintIdx)
+	{
+		if (ConstraintTypes[ConstraintIdx] == Bend)
+			continue;
+
+		const int32 IdxA = Constraints.IndexA[ConstraintIdx];
+		const int32 IdxB = Constraints.IndexB[ConstraintIdx];
+		const int32 EdgeA = EdgeOffsets[IdxA] + EdgeCounts[IdxA]++;
+		const int32 EdgeB = EdgeOffsets[IdxB] + EdgeCounts[IdxB]++;
+		EdgeParticles[EdgeA] = IdxB;
+		EdgeParticles[EdgeB] = IdxA;
+		EdgeLengths[EdgeA] = EdgeLengths[EdgeB] = Constraints.RestLength[ConstraintIdx];
+	}
+
+	// Shortest path from all pinned particles at once, a path along the edges is never shorter than the cloth in between
+	struct FPathNode
+	{
+		float Length;
+		int32 Idx;
+
+		bool operator<(const FPathNode& Other) const
+		{
+			return Length < Other.Length;
+		}
+	};
+
+	TArray<float> PathLengths;
+	TArray<int32> Anchors;
+	TArray<FPathNode> Heap;
+	PathLengths.Init(MAX_flt, NumParticles);
+	Anchors.Init(INDEX_NONE, NumParticles);
+	for (int32 Idx : PinnedParticles)
+	{
+		PathLengths[Idx] = 0.0f;
+		Anchors[Idx] = Idx;
+		Heap.HeapPush({ 0.0f, Idx });
+	}
+
+	while (Heap.Num() > 0)
+	{
+		FPathNode Node;
+		Heap.HeapPop(Node, false);
+		if (Node.Length > PathLengths[Node.Idx])
+			continue;
+
+		for (int32 EdgeIdx = EdgeOffsets[Node.Idx]; EdgeIdx < EdgeOffsets[Node.Idx + 1]; ++EdgeIdx)
+		{
+			const int32 Other = EdgeParticles[EdgeIdx];
+			const float Length = Node.Length + EdgeLengths[EdgeIdx];
+			if (Length < PathLengths[Other])
+			{
+				PathLengths[Other] = Length;
+				Anchors[Other] = Anchors[Node.Idx];
+				Heap.HeapPush({ Length, Other });
+			}
+		}
+	}
+
+	// Pieces torn off every pinned particle have no anchor
+	for (int32 Idx = 0; Idx < NumParticles; ++Idx)
+	{
+		if (!Pinned[Idx] && Anchors[Idx] != INDEX_NONE)
+			OutTethers.Add(Anchors[Idx], Idx, PathLengths[Idx] * Scale);
+	}
+	OutTethers.Pad(NullIdx);
+}
+
+int32 FVerletClothTopology::SplitParticle(int32 Idx, const FVector& Normal, const FVerletClothParticles& Particles, FVerletClothMeshPatch& OutPatch)
+{
+	if (Pinned[Idx] || NumParticles >= MaxParticles)
+		return INDEX_NONE;
+
+	// Triangles of the particle on either side of the tear
+	const FVector Position = Particles.GetPosition(Idx);
+	TArray<int32, TInlineAllocator<16>> KeptTriangles;
+	TArray<int32, TInlineAllocator<16>> MovedTriangles;
+	for (int32 TriangleIdx = 0; TriangleIdx * 3 < Triangles.Num(); ++TriangleIdx)
+	{
+		const int32* Corners = &Triangles[TriangleIdx * 3];
+		if (Corners[0] != Idx && Corners[1] != Idx && Corners[2] != Idx)
+			continue;
+
+		const FVector Center = (Particles.GetPosition(Corners[0]) + Particles.GetPosition(Corners[1]) + Particles.GetPosition(Corners[2])) / 3.0f;
+		if (((Center - Position) | Normal) > 0.0f)
+			MovedTriangles.Add(TriangleIdx);
+		else
+			KeptTriangles.Add(TriangleIdx);
+	}
+
+	if (KeptTriangles.Num() == 0 || MovedTriangles.Num() == 0)
+		return INDEX_NONE;
+
+	// Rendered vertices of the particle used on both sides are duplicated, the others just follow the new particle
+	TArray<uint32, TInlineAllocator<8>> SharedVertices;
+	if (HasRenderMesh())
+	{
+		for (int32 TriangleIdx : MovedTriangles)
+		{
+			for (int32 Corner = 0; Corner < 3; ++Corner)
+			{
+				const uint32 VertIdx = RenderIndices[TriangleIdx * 3 + Corner];
+				if (RenderParticles[VertIdx] != Idx || SharedVertices.Contains(VertIdx))
+					continue;
+
+				for (int32 KeptIdx : KeptTriangles)
+				{
+					const uint32* KeptCorners = &RenderIndices[KeptIdx * 3];
+					if (KeptCorners[0] == VertIdx || KeptCorners[1] == VertIdx || KeptCorners[2] == VertIdx)
+					{
+						SharedVertices.Add(VertIdx);
+						break;
+					}
+				}
+			}
+		}
+
+		if (RenderParticles.Num() + SharedVertices.Num() > MaxRenderVertices)
+			return INDEX_NONE;
+	}
+
+	const int32 NewIdx = NumParticles++;
+	const FVector RestPosition = RestPositions[Idx];
+	RestPositions.Add(RestPosition);
+	Pinned.Add(false);
+	bTorn = true;
+
+	TArray<int32, TInlineAllocator<8>> NewVertices;
+	for (uint32 VertIdx : SharedVertices)
+	{
+		if (OutPatch.SourceVertices.Num() == 0)
+			OutPatch.FirstNewVertex = RenderParticles.Num();
+
+		const FVector2D UV = RenderUVs[VertIdx];
+		const FColor Color = RenderColors[VertIdx];
+		NewVertices.Add(RenderParticles.Add(NewIdx));
+		RenderUVs.Add(UV);
+		RenderColors.Add(Color);
+		OutPatch.SourceVertices.Add(VertIdx);
+	}
+
+	for (int32 TriangleIdx : MovedTriangles)
+	{
+		for (int32 Corner = 0; Corner < 3; ++Corner)
+		{
+			if (Triangles[TriangleIdx * 3 + Corner] == Idx)
+				Triangles[TriangleIdx * 3 + Corner] = NewIdx;
+		}
+
+		if (!HasRenderMesh())
+			continue;
+
+		bool bPatched = false;
+		for (int32 Corner = 0; Corner < 3; ++Corner)
+		{
+			uint32& VertIdx = RenderIndices[TriangleIdx * 3 + Corner];
+			const int32 SharedIdx = SharedVertices.Find(VertIdx);
+			if (SharedIdx != INDEX_NONE)
+			{
+				VertIdx = NewVertices[SharedIdx];
+				bPatched = true;
+			}
+			else if (RenderParticles[VertIdx] == Idx)
+			{
+				RenderParticles[VertIdx] = NewIdx;
+			}
+		}
+
+		if (bPatched)
+		{
+			OutPatch.Triangles.Add(TriangleIdx);
+			for (int32 Corner = 0; Corner < 3; ++Corner)
+				OutPatch.TriangleIndices.Add(RenderIndices[TriangleIdx * 3 + Corner]);
+		}
+	}
+
+	// Constraints follow their other particle, edges along the tear are kept by both sides.
+	// Particles outside the triangles, such as bending ones, go by the side of the plane they are on.
+	auto IsOnSide = [this](const TArray<int32, TInlineAllocator<16>>& SideTriangles, int32 Other)
+	{
+		for (int32 TriangleIdx : SideTriangles)
+		{
+			const int32* Corners = &Triangles[TriangleIdx * 3];
+			if (Corners[0] == Other || Corners[1] == Other || Corners[2] == Other)
+				return true;
+		}
+		return false;
+	};
+
+	const int32 NumConstraints = Constraints.Num();
+	for (int32 ConstraintIdx = 0; ConstraintIdx < NumConstraints; ++ConstraintIdx)
+	{
+		const int32 IdxA = Constraints.IndexA[ConstraintIdx];
+		const int32 IdxB = Constraints.IndexB[ConstraintIdx];
+		if (IdxA != Idx && IdxB != Idx)
+			continue;
+
+		const int32 Other = IdxA == Idx ? IdxB : IdxA;
+		const bool bKept = IsOnSide(KeptTriangles, Other);
+		const bool bMoved = IsOnSide(MovedTriangles, Other);
+		if (bKept && bMoved)
+		{
+			const float RestLength = Constraints.RestLength[ConstraintIdx];
+			const uint8 Type = ConstraintTypes[ConstraintIdx];
+			Constraints.Add(FMath::Min(NewIdx, Other), FMath::Max(NewIdx, Other), RestLength);
+			ConstraintTypes.Add(Type);
+		}
+		else if (bMoved || (!bKept && ((Particles.GetPosition(Other) - Position) | Normal) > 0.0f))
+		{
+			Constraints.IndexA[ConstraintIdx] = FMath::Min(NewIdx, Other);
+			Constraints.IndexB[ConstraintIdx] = FMath::Max(NewIdx, Other);
+		}
+	}
+
+	return NewIdx;
+}
+
+void FVerletClothTopology::AddConstraint(int32 IdxA, int32 IdxB, EConstraintType Type)
+{
+	Constraints.Add(FMath::Min(IdxA, IdxB), FMath::Max(IdxA, IdxB), FVector::Dist(RestPositions[IdxA], RestPositions[IdxB]));
+	ConstraintTypes.Add((uint8)Type);
+}
+
+void FVerletClothTopology::AddTriangle(int32 IdxA, int32 IdxB, int32 IdxC)
+{
+	Triangles.Add(IdxA);
+	Triangles.Add(IdxB);
+	Triangles.Add(IdxC);
+}
+
+void FVerletClothTopology::Finish()
+{
+	struct FSortedConstraint
+	{
+		int32 IdxA;
+		int32 IdxB;
+		float RestLength;
+		uint8 Type;
+
+		bool operator<(const FSortedConstraint& Other) const
+		{
+			if (Type != Other.Type)
+				return Type < Other.Type;
+			return IdxA != Other.IdxA ? IdxA < Other.IdxA : IdxB < Other.IdxB;
+		}
+	};
+
+	// Constraints between two pinned particles never move anything
+	TArray<FSortedConstraint> Sorted;
+	Sorted.Reserve(Constraints.Num());
+	for (int32 ConstraintIdx = 0; ConstraintIdx < Constraints.Num(); ++ConstraintIdx)
+	{
+		const int32 IdxA = Constraints.IndexA[ConstraintIdx];
+		const int32 IdxB = Constraints.IndexB[ConstraintIdx];
+		if (!Pinned[IdxA] || !Pinned[IdxB])
+			Sorted.Add({ IdxA, IdxB, Constraints.RestLength[ConstraintIdx], ConstraintTypes[ConstraintIdx] });
+	}
+	Sorted.Sort();
+
+	Constraints = FVerletClothConstraintBatch();
+	ConstraintTypes.Reset();
+	for (const FSortedConstraint& Constraint : Sorted)
+	{
+		Constraints.Add(Constraint.IdxA, Constraint.IdxB, Constraint.RestLength);
+		ConstraintTypes.Add(Constraint.Type);
+	}
+
+	PinnedParticles.Reset();
+	for (int32 Idx = 0; Idx < NumParticles; ++Idx)
+	{
+		if (Pinned[Idx])
+			PinnedParticles.Add(Idx);
+	}
+
+	InvTriangleCounts.Init(0.0f, NumParticles);
+	for (int32 Idx : Triangles)
+		InvTriangleCounts[Idx] += 1.0f;
+	for (float& Count : InvTriangleCounts)
+		Count = Count > 0.0f ? 1.0f / Count : 0.0f;
+
+	for (int32 Corner = 0; Corner < 3; ++Corner)
+	{
+		TriangleCorners[Corner].Reset();
+		for (int32 Idx = Corner; Idx < Triangles.Num(); Idx += 3)
+			TriangleCorners[Corner].Add(Triangles[Idx]);
+	}
+}
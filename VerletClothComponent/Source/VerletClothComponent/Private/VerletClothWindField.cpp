@@ -0,0 +1,108 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothWindField.h"
+
+//////////////////////////////////////////////////////////////////////////
+// FVerletClothConstantWind
+
+FVerletClothConstantWind::FVerletClothConstantWind(const FVector& InVelocity)
+	: Velocity(InVelocity)
+{
+}
+
+void FVerletClothConstantWind::SampleWind(const float* PosX, const float* PosY, const float* PosZ, int32 Num, float Time, float* OutX, float* OutY, float* OutZ) const
+{
+	for (int32 Idx = 0; Idx < Num; ++Idx)
+	{
+		OutX[Idx] = Velocity.X;
+		OutY[Idx] = Velocity.Y;
+		OutZ[Idx] = Velocity.Z;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FVerletClothGustWind
+
+FVerletClothGustWind::FVerletClothGustWind(const FVector& InVelocity, float InGustStrength, float InGustFrequency)
+	: Velocity(InVelocity)
+	, GustStrength(InGustStrength)
+	, GustFrequency(InGustFrequency)
+{
+}
+
+void FVerletClothGustWind::SampleWind(const float* PosX, const float* PosY, const float* PosZ, int32 Num, float Time, float* OutX, float* OutY, float* OutZ) const
+{
+	const float Speed = Velocity.Size();
+	if (Speed <= KINDA_SMALL_NUMBER || GustStrength <= 0.0f)
+	{
+		FVerletClothConstantWind(Velocity).SampleWind(PosX, PosY, PosZ, Num, Time, OutX, OutY, OutZ);
+		return;
+	}
+
+	// Gusts travel at the wind speed, the phase only depends on how far along the wind a particle is.
+	// Two waves of unrelated frequencies keep them from looking periodic.
+	const FVector Direction = Velocity / Speed;
+	const float PhaseScale = 2.0f * PI * GustFrequency / Speed;
+	const float TimePhase = 2.0f * PI * GustFrequency * Time;
+	for (int32 Idx = 0; Idx < Num; ++Idx)
+	{
+		const float Phase = (PosX[Idx] * Direction.X + PosY[Idx] * Direction.Y + PosZ[Idx] * Direction.Z) * PhaseScale - TimePhase;
+		const float Gust = 0.6f * FMath::Sin(Phase) + 0.4f * FMath::Sin(2.7f * Phase + 1.3f);
+		const FVector Wind = Velocity * (1.0f + GustStrength * Gust);
+		OutX[Idx] = Wind.X;
+		OutY[Idx] = Wind.Y;
+		OutZ[Idx] = Wind.Z;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FVerletClothWindVolume
+
+FVerletClothWindVolume::FVerletClothWindVolume(const FBox& InBounds, const FIntVector& InResolution, const TArray<FVector>& InVelocities)
+	: Bounds(InBounds)
+	, Resolution(InResolution)
+	, Velocities(InVelocities)
+{
+	check(Resolution.X >= 2 && Resolution.Y >= 2 && Resolution.Z >= 2);
+	check(Velocities.Num() == Resolution.X * Resolution.Y * Resolution.Z);
+}
+
+void FVerletClothWindVolume::SampleWind(const float* PosX, const float* PosY, const float* PosZ, int32 Num, float Time, float* OutX, float* OutY, float* OutZ) const
+{
+	const FVector Size = Bounds.Max - Bounds.Min;
+	const FVector CellScale(
+		(Resolution.X - 1) / FMath::Max(Size.X, KINDA_SMALL_NUMBER),
+		(Resolution.Y - 1) / FMath::Max(Size.Y, KINDA_SMALL_NUMBER),
+		(Resolution.Z - 1) / FMath::Max(Size.Z, KINDA_SMALL_NUMBER));
+	const int32 StrideY = Resolution.X;
+	const int32 StrideZ = Resolution.X * Resolution.Y;
+
+	// Cell and position within it along one axis, the last cell covers the far side of the box
+	auto Locate = [](float Position, float Min, float Scale, int32 AxisResolution, int32& OutCell) -> float
+	{
+		const float Coord = FMath::Clamp((Position - Min) * Scale, 0.0f, (float)(AxisResolution - 1));
+		OutCell = FMath::Min(FMath::FloorToInt(Coord), AxisResolution - 2);
+		return Coord - OutCell;
+	};
+
+	for (int32 Idx = 0; Idx < Num; ++Idx)
+	{
+		int32 X, Y, Z;
+		const float FracX = Locate(PosX[Idx], Bounds.Min.X, CellScale.X, Resolution.X, X);
+		const float FracY = Locate(PosY[Idx], Bounds.Min.Y, CellScale.Y, Resolution.Y, Y);
+		const float FracZ = Locate(PosZ[Idx], Bounds.Min.Z, CellScale.Z, Resolution.Z, Z);
+
+		const FVector* Corner = Velocities.GetData() + X + Y * StrideY + Z * StrideZ;
+		const FVector Bottom = FMath::Lerp(
+			FMath::Lerp(Corner[0], Corner[1], FracX),
+			FMath::Lerp(Corner[StrideY], Corner[StrideY + 1], FracX), FracY);
+		const FVector Top = FMath::Lerp(
+			FMath::Lerp(Corner[StrideZ], Corner[StrideZ + 1], FracX),
+			FMath::Lerp(Corner[StrideZ + StrideY], Corner[StrideZ + StrideY + 1], FracX), FracY);
+		const FVector Wind = FMath::Lerp(Bottom, Top, FracZ);
+		OutX[Idx] = Wind.X;
+		OutY[Idx] = Wind.Y;
+		OutZ[Idx] = Wind.Z;
+	}
+}
@@ -0,0 +1,345 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+/**
+ * Microbenchmarks of the simulation core, every step of a substep of FVerletClothSolver on its own over a range of cloth sizes,
+ * thread counts and with the vectorized kernels on and off. The cloth is reset between calls outside of the measured time.
+ *
+ * Usage: VerletClothBenchmarks [--filter=Substring] [--min_time=Seconds] [--threads=1,2,4]
+ * Prints one line per run, the time of one call and the time per particle.
+ */
+
+#include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothKernels.h"
+#include "VerletClothSolver.h"
+#include "VerletClothWindField.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace
+{
+	/** Cloth hanging from its first line, swung a little so constraints and collisions have work to do */
+	struct FBenchmarkCloth
+	{
+		FBenchmarkCloth(int32 NumSides, int32 NumSegments)
+			: Solver(Particles, Topology, Batches, BatchTypes, Tethers)
+		{
+			Topology.BuildGrid(NumSegments + 1, NumSides + 1, 1, 100.0f, 100.0f, false);
+			Particles.Init(NumSegments + 1, NumSides + 1);
+			for (int32 Idx = 0; Idx < Particles.NumParticles; ++Idx)
+			{
+				const FVector Rest = Topology.RestPositions[Idx];
+				const bool bFree = !Topology.Pinned[Idx];
+				// Hanging down and stretched a bit
+				const FVector Position(Rest.X, 0.0f, -Rest.Y * (bFree ? 1.05f : 1.0f));
+				Particles.SetPosition(Idx, Position);
+				Particles.SetSavedPosition(Idx, bFree ? Position + FVector(0.1f, 0.2f, 0.0f) : FVector::ZeroVector);
+				Particles.SetFree(Idx, bFree);
+			}
+
+			Topology.BuildBatches(Batches, BatchTypes, Particles.GetNullIndex());
+			VerletClothKernels::SetAcceleration(Particles, FVector(0.0f, 0.0f, -980.0f));
+			Initial = Particles.Buffer;
+
+			// Over relaxed and exiting early once converged, the chunks of the parallel solver as verletcloth.ParallelSolver.BatchSize
+			Settings.SolverIterations = 4;
+			Settings.SolverTolerance = 0.01f;
+			Settings.SolverRelaxation = 1.5f;
+			Settings.ParallelBatchSize = 256;
+			Settings.WindDrag = 1.0f;
+			Settings.WindLift = 0.5f;
+
+			// The pinned line is held where it hangs, its saved positions are 0
+			Input.TimeStep = 1.0f / 60.0f;
+			Input.Gravity = FVector(0.0f, 0.0f, -980.0f);
+			Input.NumPinnedLines = 1;
+			Input.PinnedLineStart = Particles.GetPosition(Particles.GetIndex(0, 0));
+			Input.PinnedLineDelta = Particles.GetPosition(Particles.GetIndex(0, 1)) - Input.PinnedLineStart;
+		}
+
+		/** Puts the particles back where they started, so every run does the same work */
+		void Reset()
+		{
+			FMemory::Memcpy(Particles.Buffer.GetData(), Initial.GetData(), Initial.Num() * sizeof(float));
+		}
+
+		FVerletClothTopology Topology;
+		FVerletClothParticles Particles;
+		TArray<FVerletClothConstraintBatch> Batches;
+		TArray<uint8> BatchTypes;
+		FVerletClothConstraintBatch Tethers;
+		TArray<float, TAlignedHeapAllocator<FVerletClothParticles::StreamAlignment * sizeof(float)>> Initial;
+		FVerletClothSimulationSettings Settings;
+		FVerletClothSubstepInput Input;
+		FVerletClothSolver Solver;
+	};
+
+	struct FBenchmark
+	{
+		const char* Name;
+		/** Returns the function timed, called as many times as fit in the minimum time */
+		std::function<std::function<void()>(FBenchmarkCloth&)> Setup;
+		/** Only measured once per thread count when it does not use ParallelFor */
+		bool bParallel;
+		/** Moves the particles, the cloth is reset after every call and the time of the resets is taken off */
+		bool bReset;
+	};
+
+	TArray<FBenchmark> GetBenchmarks()
+	{
+		TArray<FBenchmark> Benchmarks;
+
+		Benchmarks.Add({ "Integrate", [](FBenchmarkCloth& Cloth)
+		{
+			return [&Cloth]()
+			{
+				Cloth.Solver.Integrate(Cloth.Settings, Cloth.Input);
+			};
+		}, false, true });
+
+		Benchmarks.Add({ "SolveSequential", [](FBenchmarkCloth& Cloth)
+		{
+			return [&Cloth]()
+			{
+				Cloth.Solver.SolveConstraints(Cloth.Settings, Cloth.Input.TimeStep);
+			};
+		}, false, true });
+
+		Benchmarks.Add({ "SolveBatched", [](FBenchmarkCloth& Cloth)
+		{
+			Cloth.Settings.bParallelSolver = true;
+			return [&Cloth]()
+			{
+				Cloth.Solver.SolveConstraints(Cloth.Settings, Cloth.Input.TimeStep);
+			};
+		}, true, true });
+
+		Benchmarks.Add({ "SolveXPBD", [](FBenchmarkCloth& Cloth)
+		{
+			Cloth.Settings.bParallelSolver = true;
+			Cloth.Settings.bUseXPBD = true;
+			for (int32 Type = 0; Type < FVerletClothTopology::NumConstraintTypes; ++Type)
+				Cloth.Settings.Compliance[Type] = 1.0e-6f;
+			return [&Cloth]()
+			{
+				Cloth.Solver.SolveConstraints(Cloth.Settings, Cloth.Input.TimeStep);
+			};
+		}, true, true });
+
+		Benchmarks.Add({ "Collide", [](FBenchmarkCloth& Cloth)
+		{
+			auto Colliders = std::make_shared<TArray<FVerletClothCollider>>();
+			Colliders->AddDefaulted(2);
+			FVerletClothCollider& Capsule = (*Colliders)[0];
+			Capsule.bBox = false;
+			Capsule.Start = FVector(20.0f, -10.0f, -40.0f);
+			Capsule.End = FVector(80.0f, -10.0f, -40.0f);
+			Capsule.Radius = 15.0f;
+			Capsule.Bounds = FBox(FVector(5.0f, -25.0f, -55.0f), FVector(95.0f, 5.0f, -25.0f));
+			FVerletClothCollider& Box = (*Colliders)[1];
+			Box.bBox = true;
+			Box.Start = Box.End = FVector(50.0f, 0.0f, -80.0f);
+			Box.Rotation = FQuat(FVector(0.0f, 0.0f, 1.0f), 0.3f);
+			Box.Extent = FVector(20.0f, 10.0f, 10.0f);
+			Box.Bounds = FBox(Box.Start - FVector(Box.Extent.Size()), Box.Start + FVector(Box.Extent.Size()));
+
+			Cloth.Input.bCollisionPlane = true;
+			Cloth.Input.CollisionPlane = FPlane(0.0f, 0.0f, 1.0f, -50.0f);
+			Cloth.Input.Colliders = Colliders->GetData();
+			Cloth.Input.NumColliders = Colliders->Num();
+
+			// The broadphase bounds come from the integration
+			Cloth.Solver.Integrate(Cloth.Settings, Cloth.Input);
+			Cloth.Reset();
+			return [&Cloth, Colliders]()
+			{
+				Cloth.Solver.ProcessCollision(Cloth.Input);
+			};
+		}, false, true });
+
+		Benchmarks.Add({ "SelfCollision", [](FBenchmarkCloth& Cloth)
+		{
+			return [&Cloth]()
+			{
+				Cloth.Solver.SolveSelfCollision(2.0f);
+			};
+		}, true, true });
+
+		Benchmarks.Add({ "Aerodynamics", [](FBenchmarkCloth& Cloth)
+		{
+			auto Wind = std::make_shared<FVerletClothGustWind>(FVector(300.0f, 100.0f, 0.0f), 0.5f, 0.5f);
+			Cloth.Input.WindField = Wind.get();
+			Cloth.Input.Time = 1.0f;
+			return [&Cloth, Wind]()
+			{
+				Cloth.Solver.UpdateAcceleration(Cloth.Settings, Cloth.Input);
+			};
+		}, false, false });
+
+		Benchmarks.Add({ "MeshBuild", [](FBenchmarkCloth& Cloth)
+		{
+			auto Positions = std::make_shared<TArray<FVector>>();
+			auto Tangents = std::make_shared<TArray<uint32>>();
+			return [&Cloth, Positions, Tangents]()
+			{
+				const FVerletClothParticles& Particles = Cloth.Particles;
+				Positions->SetNumUninitialized(Particles.NumParticles);
+				for (int32 Idx = 0; Idx < Particles.NumParticles; ++Idx)
+					(*Positions)[Idx] = Particles.GetPosition(Idx);
+				Tangents->SetNumUninitialized(Particles.NumParticles * 2);
+				VerletClothKernels::ComputeGridTangents(Positions->GetData(), Particles.NumLines, Particles.NumPointsPerLine, Tangents->GetData());
+			};
+		}, true, false });
+
+		Benchmarks.Add({ "TopologyBuild", [](FBenchmarkCloth& Cloth)
+		{
+			auto Topology = std::make_shared<FVerletClothTopology>();
+			auto Batches = std::make_shared<TArray<FVerletClothConstraintBatch>>();
+			auto BatchTypes = std::make_shared<TArray<uint8>>();
+			auto Tethers = std::make_shared<FVerletClothConstraintBatch>();
+			return [&Cloth, Topology, Batches, BatchTypes, Tethers]()
+			{
+				const FVerletClothParticles& Particles = Cloth.Particles;
+				Topology->BuildGrid(Particles.NumLines, Particles.NumPointsPerLine, 1, 100.0f, 100.0f, false);
+				Topology->BuildBatches(*Batches, *BatchTypes, Particles.GetNullIndex());
+				*Tethers = FVerletClothConstraintBatch();
+				Topology->BuildTethers(*Tethers, 1.0f, Particles.GetNullIndex());
+			};
+		}, false, false });
+
+		return Benchmarks;
+	}
+
+	typedef std::chrono::steady_clock FClock;
+
+	/** Seconds NumCalls calls of Function take, each followed by Reset when there is one */
+	double TimeCalls(const std::function<void()>& Function, const std::function<void()>& Reset, int64 NumCalls)
+	{
+		const FClock::time_point Start = FClock::now();
+		for (int64 CallIdx = 0; CallIdx < NumCalls; ++CallIdx)
+		{
+			Function();
+			if (Reset)
+				Reset();
+		}
+		return std::chrono::duration<double>(FClock::now() - Start).count();
+	}
+
+	/**
+	 * Calls Function until MinTime went by, returns the average time of one call in nanoseconds.
+	 * Reset, when given, runs after every call and as many times on its own, and its time is taken off.
+	 */
+	double Measure(const std::function<void()>& Function, const std::function<void()>& Reset, double MinTime)
+	{
+		// Warm up caches and the worker threads
+		Function();
+		if (Reset)
+			Reset();
+
+		int64 NumCalls = 1;
+		for (;;)
+		{
+			const double Elapsed = TimeCalls(Function, Reset, NumCalls);
+			if (Elapsed >= MinTime)
+			{
+				const double ResetTime = Reset ? TimeCalls(Reset, std::function<void()>(), NumCalls) : 0.0;
+				return FMath::Max(Elapsed - ResetTime, 0.0) * 1.0e9 / (double)NumCalls;
+			}
+
+			// Aim a little past the minimum time so the next round is the last one
+			NumCalls = Elapsed > 0.0 ? FMath::Max((int64)(NumCalls * 1.4 * MinTime / Elapsed), NumCalls + 1) : NumCalls * 10;
+		}
+	}
+
+	TArray<int32> ParseThreads(const std::string& Value)
+	{
+		TArray<int32> Threads;
+		size_t Start = 0;
+		while (Start < Value.size())
+		{
+			size_t End = Value.find(',', Start);
+			if (End == std::string::npos)
+				End = Value.size();
+			Threads.Add(FMath::Max(atoi(Value.substr(Start, End - Start).c_str()), 1));
+			Start = End + 1;
+		}
+		return Threads;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string Filter;
+	double MinTime = 0.1;
+	const int32 HardwareThreads = FMath::Max((int32)std::thread::hardware_concurrency(), 1);
+	TArray<int32> ThreadCounts;
+	for (int32 NumThreads : { 1, 2, 4, HardwareThreads })
+	{
+		if (NumThreads <= HardwareThreads && !ThreadCounts.Contains(NumThreads))
+			ThreadCounts.Add(NumThreads);
+	}
+
+	for (int32 ArgIdx = 1; ArgIdx < argc; ++ArgIdx)
+	{
+		const std::string Arg = argv[ArgIdx];
+		if (Arg.compare(0, 9, "--filter=") == 0)
+			Filter = Arg.substr(9);
+		else if (Arg.compare(0, 11, "--min_time=") == 0)
+			MinTime = atof(Arg.substr(11).c_str());
+		else if (Arg.compare(0, 10, "--threads=") == 0)
+			ThreadCounts = ParseThreads(Arg.substr(10));
+		else
+		{
+			fprintf(stderr, "Usage: %s [--filter=Substring] [--min_time=Seconds] [--threads=1,2,4]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	IConsoleVariable* SimdVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("verletcloth.Simd"));
+	check(SimdVariable != nullptr);
+
+	printf("%-48s %8s %14s %14s\n", "Benchmark", "Threads", "Time (ns)", "Per particle");
+
+	const TArray<FBenchmark> Benchmarks = GetBenchmarks();
+	for (const FBenchmark& Benchmark : Benchmarks)
+	{
+		for (int32 NumSides : { 1, 8, 64 })
+		{
+			for (int32 NumSegments : { 1, 20, 200 })
+			{
+				for (int32 bSimd = 0; bSimd <= 1; ++bSimd)
+				{
+					char Name[128];
+					snprintf(Name, sizeof(Name), "%s/%dx%d/%s", Benchmark.Name, NumSides, NumSegments, bSimd ? "Simd" : "Scalar");
+					if (!Filter.empty() && std::string(Name).find(Filter) == std::string::npos)
+						continue;
+
+					SimdVariable->Set(bSimd);
+					FBenchmarkCloth Cloth(NumSides, NumSegments);
+					const std::function<void()> Function = Benchmark.Setup(Cloth);
+					std::function<void()> Reset;
+					if (Benchmark.bReset)
+						Reset = [&Cloth]() { Cloth.Reset(); };
+
+					for (int32 NumThreads : ThreadCounts)
+					{
+						VerletClothStandalone::SetNumWorkerThreads(NumThreads);
+						const double Time = Measure(Function, Reset, MinTime);
+						printf("%-48s %8d %14.1f %14.2f\n", Name, NumThreads, Time, Time / Cloth.Particles.NumParticles);
+						fflush(stdout);
+
+						if (!Benchmark.bParallel)
+							break;
+					}
+				}
+			}
+		}
+	}
+
+	VerletClothStandalone::SetNumWorkerThreads(HardwareThreads);
+	return 0;
+}
@@ -0,0 +1,439 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+/**
+ * Golden file regression harness of the simulation core. A few fixed scenes are simulated by FVerletClothSolver in deterministic mode,
+ * the code the component runs, and snapshots taken along the way are compared with golden ones.
+ * Every scene runs with the scalar and the vectorized kernels, on one and on every thread, so a kernel change is checked
+ * for accuracy and speed in one run. The reference run, scalar on one thread, is also checked to repeat bit for bit.
+ *
+ * Usage: VerletClothRegression --golden=Dir [--update] [--filter=Substring] [--tolerance=Distance]
+ * --update writes the golden files from the reference run instead of comparing with them.
+ */
+
+#include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothSnapshot.h"
+#include "VerletClothSolver.h"
+#include "VerletClothWindField.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace
+{
+	/** Frames simulated per scene, and the frames between two snapshots */
+	const int32 NumFrames = 120;
+	const int32 SnapshotInterval = 30;
+	const int32 SubstepsPerFrame = 2;
+
+	struct FRegressionScene
+	{
+		const char* Name;
+		int32 NumSides;
+		int32 NumSegments;
+		float ClothLength;
+		float ClothWidth;
+		FVerletClothSnapshotParams Params;
+		float GustStrength;
+		/** The pinned line swings back and forth along X this far */
+		float SwayAmplitude;
+		bool bGroundPlane;
+		TArray<FVerletClothCollider> Colliders;
+	};
+
+	FVerletClothCollider MakeCapsule(const FVector& Start, const FVector& End, float Radius)
+	{
+		FVerletClothCollider Collider;
+		Collider.bBox = false;
+		Collider.Start = Start;
+		Collider.End = End;
+		Collider.Radius = Radius;
+		Collider.Rotation = FQuat::Identity;
+		Collider.Extent = FVector::ZeroVector;
+		return Collider;
+	}
+
+	FVerletClothCollider MakeBox(const FVector& Center, const FQuat& Rotation, const FVector& Extent)
+	{
+		FVerletClothCollider Collider;
+		Collider.bBox = true;
+		Collider.Start = Center;
+		Collider.End = Center;
+		Collider.Radius = 0.0f;
+		Collider.Rotation = Rotation;
+		Collider.Extent = Extent;
+		return Collider;
+	}
+
+	TArray<FRegressionScene> GetScenes()
+	{
+		TArray<FRegressionScene> Scenes;
+
+		// Parallel solver with the default chunk size of verletcloth.ParallelSolver.BatchSize
+		FVerletClothSnapshotParams Params;
+		Params.SubstepTime = 1.0f / 60.0f;
+		Params.Settings.SolverIterations = 10;
+		Params.Settings.SolverTolerance = 0.01f;
+		Params.Settings.SolverRelaxation = 1.0f;
+		Params.Settings.Damping = 0.01f;
+		Params.Settings.bParallelSolver = true;
+		Params.Settings.ParallelBatchSize = 256;
+		Params.Gravity = FVector(0.0f, 0.0f, -980.0f);
+
+		// Flag in gusty wind, PBD with over-relaxation
+		{
+			FRegressionScene Scene = { "Flag", 12, 16, 100.0f, 80.0f, Params, 0.5f, 0.0f, false };
+			Scene.Params.Settings.SolverRelaxation = 1.5f;
+			Scene.Params.Wind = FVector(0.0f, 400.0f, 0.0f);
+			Scene.Params.Settings.WindDrag = 1.0f;
+			Scene.Params.Settings.WindLift = 0.5f;
+			Scenes.Add(Scene);
+		}
+
+		// Swinging curtain draped over a capsule and a box, XPBD with tethers
+		{
+			FRegressionScene Scene = { "Curtain", 10, 20, 150.0f, 100.0f, Params, 0.0f, 30.0f, true };
+			Scene.Params.Settings.bUseXPBD = true;
+			Scene.Params.Settings.Compliance[FVerletClothTopology::Structural] = 1.0e-6f;
+			Scene.Params.Settings.Compliance[FVerletClothTopology::Shear] = 1.0e-5f;
+			Scene.Params.TetherScale = 1.05f;
+			Scene.Colliders.Add(MakeCapsule(FVector(-40.0f, 20.0f, -80.0f), FVector(40.0f, 20.0f, -80.0f), 15.0f));
+			Scene.Colliders.Add(MakeBox(FVector(0.0f, -10.0f, -130.0f), FQuat(FVector(0.0f, 0.0f, 1.0f), 0.4f), FVector(20.0f, 10.0f, 10.0f)));
+			Scenes.Add(Scene);
+		}
+
+		// Long swaying cloth folding onto itself, kept apart by self collision, with the sequential solver
+		{
+			FRegressionScene Scene = { "Fold", 8, 24, 200.0f, 60.0f, Params, 0.0f, 10.0f, false };
+			Scene.Params.Settings.bParallelSolver = false;
+			Scene.Params.Settings.SelfCollisionThickness = 3.0f;
+			Scenes.Add(Scene);
+		}
+
+		return Scenes;
+	}
+
+	/** Simulation of a scene by the solver of the component, frame by frame in deterministic mode */
+	class FRegressionRun
+	{
+	public:
+
+		explicit FRegressionRun(const FRegressionScene& InScene)
+			: Scene(InScene)
+			, Settings(InScene.Params.Settings)
+			, TetherScale(0.0f)
+			, Solver(Particles, Topology, Batches, BatchTypes, Tethers)
+			, Wind(InScene.Params.Wind, InScene.GustStrength, 0.5f)
+			, Time(0.0f)
+			, AccumulatedTime(0.0f)
+		{
+			const int32 NumLines = Scene.NumSegments + 1;
+			const int32 NumPoints = Scene.NumSides + 1;
+			Particles.Init(NumLines, NumPoints);
+
+			// Hanging straight down from the origin, like a grid on register
+			const FVector Delta(0.0f, 0.0f, -Scene.ClothLength);
+			HorizontalStart = FVector(-Scene.ClothWidth / 2.0f, 0.0f, 0.0f);
+			HorizontalDelta = FVector(Scene.ClothWidth / (NumPoints - 1), 0.0f, 0.0f);
+			for (int32 LineIdx = 0; LineIdx < NumLines; LineIdx++)
+			{
+				const bool bFree = (LineIdx > 0);
+				const FVector RelativePosition = Delta * ((float)LineIdx / (float)Scene.NumSegments);
+				for (int32 PointIdx = 0; PointIdx < NumPoints; PointIdx++)
+				{
+					const int32 Idx = Particles.GetIndex(LineIdx, PointIdx);
+					const FVector Position = RelativePosition + HorizontalStart + HorizontalDelta * PointIdx;
+					Particles.SetPosition(Idx, Position);
+					Particles.SetSavedPosition(Idx, bFree ? Position : RelativePosition);
+					Particles.SetFree(Idx, bFree);
+				}
+			}
+
+			Topology.BuildGrid(NumLines, NumPoints, 1, Scene.ClothLength, Scene.ClothWidth, false);
+			Topology.BuildBatches(Batches, BatchTypes, Particles.GetNullIndex());
+			BuildTethers(Scene.Params.TetherScale);
+
+			for (FVerletClothCollider& Collider : Scene.Colliders)
+			{
+				const FVector Extent = Collider.bBox ? FVector(Collider.Extent.Size()) : FVector(Collider.Radius);
+				Collider.Bounds = FBox(FVector(FMath::Min(Collider.Start.X, Collider.End.X), FMath::Min(Collider.Start.Y, Collider.End.Y), FMath::Min(Collider.Start.Z, Collider.End.Z)) - Extent,
+					FVector(FMath::Max(Collider.Start.X, Collider.End.X), FMath::Max(Collider.Start.Y, Collider.End.Y), FMath::Max(Collider.Start.Z, Collider.End.Z)) + Extent);
+			}
+		}
+
+		/** Simulates the substeps of a frame, the pinned line swaying along */
+		void Frame()
+		{
+			const FVerletClothSnapshotParams& Params = Scene.Params;
+
+			float TimeStep;
+			const int32 NumSubsteps = FVerletClothSolver::GetFrameSubsteps(SubstepsPerFrame * Params.SubstepTime, 1.0f, 1.0f / Params.SubstepTime, 0, SubstepsPerFrame, AccumulatedTime, TimeStep);
+
+			FVerletClothSubstepInput Input;
+			Input.TimeStep = TimeStep;
+			Input.Gravity = Params.Gravity;
+			Input.WindField = Params.Wind.IsNearlyZero() ? NULL : &Wind;
+			Input.bCollisionPlane = Scene.bGroundPlane;
+			Input.CollisionPlane = FPlane(0.0f, 0.0f, 1.0f, -Scene.ClothLength * 0.9f);
+			Input.Colliders = Scene.Colliders.GetData();
+			Input.NumColliders = Scene.Colliders.Num();
+			Input.NumPinnedLines = 1;
+			Input.PinnedLineDelta = HorizontalDelta;
+
+			for (int32 SubstepIdx = 0; SubstepIdx < NumSubsteps; ++SubstepIdx)
+			{
+				const FVector Sway(Scene.SwayAmplitude * FMath::Sin(2.0f * PI * 0.5f * (Time + TimeStep)), 0.0f, 0.0f);
+				Input.PinnedLineStart = Sway + HorizontalStart;
+				Input.Time = Time;
+				Solver.Substep(Settings, Input);
+				Time += TimeStep;
+			}
+		}
+
+		void Capture(FVerletClothSnapshot& OutSnapshot) const
+		{
+			OutSnapshot.Time = Time;
+			OutSnapshot.Params = Scene.Params;
+			OutSnapshot.Params.Settings = Settings;
+			OutSnapshot.Params.TetherScale = TetherScale;
+			OutSnapshot.Capture(Particles);
+		}
+
+		/** Restores the particles and the settings of a snapshot like UVerletClothComponent::RestoreSnapshot */
+		bool Restore(const FVerletClothSnapshot& Snapshot)
+		{
+			if (!Snapshot.Restore(Particles))
+				return false;
+
+			// How the solver is spread over threads is not saved, the run keeps its own
+			const bool bParallelSolver = Settings.bParallelSolver;
+			const int32 ParallelBatchSize = Settings.ParallelBatchSize;
+			Settings = Snapshot.Params.Settings;
+			Settings.bParallelSolver = bParallelSolver;
+			Settings.ParallelBatchSize = ParallelBatchSize;
+			if (Snapshot.Params.TetherScale != TetherScale)
+				BuildTethers(Snapshot.Params.TetherScale);
+
+			// Replays start on a substep boundary
+			Time = Snapshot.Time;
+			AccumulatedTime = 0.0f;
+			return true;
+		}
+
+	private:
+
+		void BuildTethers(float InTetherScale)
+		{
+			TetherScale = InTetherScale;
+			if (TetherScale > 0.0f)
+				Topology.BuildTethers(Tethers, TetherScale, Particles.GetNullIndex());
+			else
+				Tethers = FVerletClothConstraintBatch();
+		}
+
+		FRegressionScene Scene;
+		FVerletClothParticles Particles;
+		FVerletClothTopology Topology;
+		TArray<FVerletClothConstraintBatch> Batches;
+		TArray<uint8> BatchTypes;
+		FVerletClothConstraintBatch Tethers;
+		FVerletClothSimulationSettings Settings;
+		float TetherScale;
+		FVerletClothSolver Solver;
+		FVerletClothGustWind Wind;
+
+		FVector HorizontalStart;
+		FVector HorizontalDelta;
+		float Time;
+		float AccumulatedTime;
+	};
+
+	/**
+	 * Simulates a scene and saves a snapshot every SnapshotInterval frames to OutData, returns the average time of a frame in microseconds.
+	 * Replays start from the first snapshot of a run instead of the beginning.
+	 */
+	double RunScene(const FRegressionScene& Scene, TArray<uint8>& OutData, const FVerletClothSnapshot* ReplayStart = nullptr)
+	{
+		typedef std::chrono::steady_clock FClock;
+
+		FRegressionRun Run(Scene);
+		if (ReplayStart && !Run.Restore(*ReplayStart))
+			return 0.0;
+
+		double Elapsed = 0.0;
+		for (int32 Frame = ReplayStart ? SnapshotInterval + 1 : 1; Frame <= NumFrames; ++Frame)
+		{
+			const FClock::time_point Start = FClock::now();
+			Run.Frame();
+			Elapsed += std::chrono::duration<double>(FClock::now() - Start).count();
+
+			if (Frame % SnapshotInterval == 0)
+			{
+				FVerletClothSnapshot Snapshot;
+				Run.Capture(Snapshot);
+				Snapshot.Save(OutData);
+			}
+		}
+		return Elapsed * 1.0e6 / NumFrames;
+	}
+
+	/** Largest difference between the snapshots of two runs, MAX_flt if they cannot be compared */
+	float CompareRuns(const TArray<uint8>& Data, const TArray<uint8>& Golden)
+	{
+		float MaxDifference = 0.0f;
+		int32 Offset = 0;
+		int32 GoldenOffset = 0;
+		while (GoldenOffset < Golden.Num())
+		{
+			FVerletClothSnapshot Snapshot, GoldenSnapshot;
+			if (!Snapshot.Load(Data, Offset) || !GoldenSnapshot.Load(Golden, GoldenOffset))
+				return MAX_flt;
+			MaxDifference = FMath::Max(MaxDifference, Snapshot.GetMaxDifference(GoldenSnapshot));
+		}
+		return Offset == Data.Num() ? MaxDifference : MAX_flt;
+	}
+
+	bool ReadFile(const std::string& Path, TArray<uint8>& OutData)
+	{
+		FILE* File = fopen(Path.c_str(), "rb");
+		if (File == nullptr)
+			return false;
+
+		uint8 Buffer[4096];
+		size_t NumRead;
+		while ((NumRead = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+		{
+			const int32 Index = OutData.AddUninitialized((int32)NumRead);
+			FMemory::Memcpy(OutData.GetData() + Index, Buffer, NumRead);
+		}
+		fclose(File);
+		return true;
+	}
+
+	bool WriteFile(const std::string& Path, const TArray<uint8>& Data)
+	{
+		FILE* File = fopen(Path.c_str(), "wb");
+		if (File == nullptr)
+			return false;
+
+		const bool bWritten = fwrite(Data.GetData(), 1, Data.Num(), File) == (size_t)Data.Num();
+		return (fclose(File) == 0) && bWritten;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string GoldenDir;
+	std::string Filter;
+	bool bUpdate = false;
+	bool bUsage = false;
+	float Tolerance = 0.05f;
+	for (int32 ArgIdx = 1; ArgIdx < argc; ++ArgIdx)
+	{
+		const std::string Arg = argv[ArgIdx];
+		if (Arg.compare(0, 9, "--golden=") == 0)
+			GoldenDir = Arg.substr(9);
+		else if (Arg.compare(0, 9, "--filter=") == 0)
+			Filter = Arg.substr(9);
+		else if (Arg.compare(0, 12, "--tolerance=") == 0)
+			Tolerance = (float)atof(Arg.substr(12).c_str());
+		else if (Arg == "--update")
+			bUpdate = true;
+		else
+			bUsage = true;
+	}
+
+	if (bUsage || GoldenDir.empty())
+	{
+		fprintf(stderr, "Usage: %s --golden=Dir [--update] [--filter=Substring] [--tolerance=Distance]\n", argv[0]);
+		return 1;
+	}
+
+	IConsoleVariable* SimdVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("verletcloth.Simd"));
+	check(SimdVariable != nullptr);
+	const int32 HardwareThreads = FMath::Max((int32)std::thread::hardware_concurrency(), 1);
+
+	printf("%-32s %8s %14s %14s\n", "Scene", "Threads", "Max error", "Frame (us)");
+
+	int32 NumFailed = 0;
+	for (const FRegressionScene& Scene : GetScenes())
+	{
+		if (!Filter.empty() && std::string(Scene.Name).find(Filter) == std::string::npos)
+			continue;
+
+		const std::string GoldenPath = GoldenDir + "/" + Scene.Name + ".snap";
+
+		// Reference run, scalar on a single thread, twice to check that it repeats exactly
+		SimdVariable->Set(0);
+		VerletClothStandalone::SetNumWorkerThreads(1);
+		TArray<uint8> Reference, Repeat;
+		RunScene(Scene, Reference);
+		RunScene(Scene, Repeat);
+		if (Reference.Num() != Repeat.Num() || memcmp(Reference.GetData(), Repeat.GetData(), Reference.Num()) != 0)
+		{
+			printf("%-32s FAILED, the reference run does not repeat\n", Scene.Name);
+			NumFailed++;
+			continue;
+		}
+
+		// Replayed from its first snapshot, the rest of the run repeats exactly too
+		FVerletClothSnapshot ReplayStart;
+		int32 ReplayOffset = 0;
+		TArray<uint8> Replay;
+		const bool bReplayStart = ReplayStart.Load(Reference, ReplayOffset);
+		if (bReplayStart)
+			RunScene(Scene, Replay, &ReplayStart);
+		if (!bReplayStart || Replay.Num() != Reference.Num() - ReplayOffset || memcmp(Replay.GetData(), Reference.GetData() + ReplayOffset, Replay.Num()) != 0)
+		{
+			printf("%-32s FAILED, the replay from a snapshot does not repeat the run\n", Scene.Name);
+			NumFailed++;
+			continue;
+		}
+
+		if (bUpdate)
+		{
+			if (!WriteFile(GoldenPath, Reference))
+			{
+				printf("%-32s FAILED, cannot write %s\n", Scene.Name, GoldenPath.c_str());
+				NumFailed++;
+				continue;
+			}
+			printf("%-32s updated %s\n", Scene.Name, GoldenPath.c_str());
+			continue;
+		}
+
+		TArray<uint8> Golden;
+		if (!ReadFile(GoldenPath, Golden))
+		{
+			printf("%-32s FAILED, cannot read %s\n", Scene.Name, GoldenPath.c_str());
+			NumFailed++;
+			continue;
+		}
+
+		for (int32 bSimd = 0; bSimd <= 1; ++bSimd)
+		{
+			for (int32 NumThreads : { 1, HardwareThreads })
+			{
+				SimdVariable->Set(bSimd);
+				VerletClothStandalone::SetNumWorkerThreads(NumThreads);
+
+				TArray<uint8> Data;
+				const double FrameTime = RunScene(Scene, Data);
+				const float Difference = CompareRuns(Data, Golden);
+				const bool bPassed = Difference <= Tolerance;
+
+				char Name[64];
+				snprintf(Name, sizeof(Name), "%s/%s", Scene.Name, bSimd ? "Simd" : "Scalar");
+				printf("%-32s %8d %14g %14.1f%s\n", Name, NumThreads, Difference, FrameTime, bPassed ? "" : "  FAILED");
+				NumFailed += bPassed ? 0 : 1;
+
+				if (HardwareThreads == 1)
+					break;
+			}
+		}
+	}
+
+	VerletClothStandalone::SetNumWorkerThreads(HardwareThreads);
+	return NumFailed > 0 ? 1 : 0;
+}
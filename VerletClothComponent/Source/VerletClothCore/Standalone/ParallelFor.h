@@ -0,0 +1,6 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// ParallelFor is part of VerletClothStandalone.h, included by the precompiled header
+#include "VerletClothStandalone.h"
@@ -0,0 +1,239 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#include "VerletClothStandalone.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+const FVector FVector::ZeroVector(0.0f, 0.0f, 0.0f);
+const FVector2D FVector2D::ZeroVector(0.0f, 0.0f);
+const FColor FColor::White(255, 255, 255);
+const FQuat FQuat::Identity(0.0f, 0.0f, 0.0f, 1.0f);
+
+//////////////////////////////////////////////////////////////////////////
+// FMemory
+
+void* FMemory::Malloc(size_t Size, uint32 Alignment)
+{
+	// Room for the aligned block and the pointer to free in front of it
+	void* Ptr = malloc(Size + Alignment + sizeof(void*));
+	if (Ptr == nullptr)
+		return nullptr;
+
+	void* Result = Align((uint8*)Ptr + sizeof(void*), Alignment);
+	((void**)Result)[-1] = Ptr;
+	return Result;
+}
+
+void FMemory::Free(void* Ptr)
+{
+	if (Ptr != nullptr)
+		free(((void**)Ptr)[-1]);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Console variables
+
+void IConsoleVariable::Set(int32 InValue, EConsoleVariableFlags SetBy)
+{
+	char Buffer[32];
+	snprintf(Buffer, sizeof(Buffer), "%d", InValue);
+	Set(Buffer, SetBy);
+}
+
+void IConsoleVariable::Set(float InValue, EConsoleVariableFlags SetBy)
+{
+	char Buffer[32];
+	snprintf(Buffer, sizeof(Buffer), "%.9g", InValue);
+	Set(Buffer, SetBy);
+}
+
+IConsoleManager& IConsoleManager::Get()
+{
+	// Constructed on first use, variables register during static initialization
+	static IConsoleManager Manager;
+	return Manager;
+}
+
+IConsoleVariable* IConsoleManager::FindConsoleVariable(const TCHAR* Name) const
+{
+	for (const auto& Variable : Variables)
+	{
+		if (strcmp(Variable.first, Name) == 0)
+			return Variable.second;
+	}
+	return nullptr;
+}
+
+void IConsoleManager::Register(const TCHAR* Name, IConsoleVariable* Variable)
+{
+	check(FindConsoleVariable(Name) == nullptr);
+	Variables.push_back(std::make_pair(Name, Variable));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ParallelFor
+
+namespace
+{
+	/**
+	 * Workers waiting for the next ParallelFor, which hands out indices one at a time to every thread until all are taken.
+	 * Only one ParallelFor runs on the pool at once, calls from inside one run on the calling thread.
+	 */
+	class FWorkerPool
+	{
+	public:
+
+		static FWorkerPool& Get()
+		{
+			static FWorkerPool Pool;
+			return Pool;
+		}
+
+		~FWorkerPool()
+		{
+			StopWorkers();
+		}
+
+		void SetNumThreads(int32 NumThreads)
+		{
+			std::lock_guard<std::mutex> RunLock(RunMutex);
+			StopWorkers();
+			StartWorkers(FMath::Max(NumThreads, 1) - 1);
+		}
+
+		int32 GetNumThreads() const
+		{
+			return (int32)Workers.size() + 1;
+		}
+
+		void Run(int32 Num, void (*Invoke)(void*, int32), void* Body, bool bForceSingleThread)
+		{
+			if (bForceSingleThread || Num <= 1 || Workers.empty() || bInsideRun)
+			{
+				for (int32 Index = 0; Index < Num; ++Index)
+					Invoke(Body, Index);
+				return;
+			}
+
+			std::lock_guard<std::mutex> RunLock(RunMutex);
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Job.Invoke = Invoke;
+				Job.Body = Body;
+				Job.Num = Num;
+				Job.NextIndex = 0;
+				NumBusyWorkers = (int32)Workers.size();
+				++Generation;
+			}
+			WakeCondition.notify_all();
+
+			Work();
+
+			std::unique_lock<std::mutex> Lock(Mutex);
+			DoneCondition.wait(Lock, [this]() { return NumBusyWorkers == 0; });
+		}
+
+	private:
+
+		struct FJob
+		{
+			void (*Invoke)(void*, int32);
+			void* Body;
+			int32 Num;
+			std::atomic<int32> NextIndex;
+		};
+
+		FWorkerPool()
+			: NumBusyWorkers(0)
+			, Generation(0)
+			, bStopping(false)
+		{
+			StartWorkers((int32)std::thread::hardware_concurrency() - 1);
+		}
+
+		void StartWorkers(int32 NumWorkers)
+		{
+			bStopping = false;
+			for (int32 WorkerIdx = 0; WorkerIdx < NumWorkers; ++WorkerIdx)
+				Workers.emplace_back([this]() { WorkerLoop(); });
+		}
+
+		void StopWorkers()
+		{
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				bStopping = true;
+			}
+			WakeCondition.notify_all();
+			for (std::thread& Worker : Workers)
+				Worker.join();
+			Workers.clear();
+		}
+
+		void Work()
+		{
+			bInsideRun = true;
+			for (int32 Index = Job.NextIndex++; Index < Job.Num; Index = Job.NextIndex++)
+				Job.Invoke(Job.Body, Index);
+			bInsideRun = false;
+		}
+
+		void WorkerLoop()
+		{
+			uint64 SeenGeneration = 0;
+			for (;;)
+			{
+				{
+					std::unique_lock<std::mutex> Lock(Mutex);
+					WakeCondition.wait(Lock, [&]() { return bStopping || Generation != SeenGeneration; });
+					if (bStopping)
+						return;
+					SeenGeneration = Generation;
+				}
+
+				Work();
+
+				std::lock_guard<std::mutex> Lock(Mutex);
+				if (--NumBusyWorkers == 0)
+					DoneCondition.notify_one();
+			}
+		}
+
+		std::vector<std::thread> Workers;
+		FJob Job;
+		int32 NumBusyWorkers;
+		uint64 Generation;
+		bool bStopping;
+
+		/** Serializes ParallelFor calls from different threads */
+		std::mutex RunMutex;
+		std::mutex Mutex;
+		std::condition_variable WakeCondition;
+		std::condition_variable DoneCondition;
+
+		static thread_local bool bInsideRun;
+	};
+
+	thread_local bool FWorkerPool::bInsideRun = false;
+}
+
+namespace VerletClothStandalone
+{
+	void SetNumWorkerThreads(int32 NumThreads)
+	{
+		FWorkerPool::Get().SetNumThreads(NumThreads);
+	}
+
+	int32 GetNumWorkerThreads()
+	{
+		return FWorkerPool::Get().GetNumThreads();
+	}
+
+	void ParallelForInternal(int32 Num, void (*Invoke)(void* Body, int32 Index), void* Body, bool bForceSingleThread)
+	{
+		FWorkerPool::Get().Run(Num, Invoke, Body, bForceSingleThread);
+	}
+}
@@ -0,0 +1,636 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+#pragma once
+
+/**
+ * The engine types and functions used by the simulation core, implemented on top of the standard library
+ * so that the core builds and runs without an engine install. Only what the core uses is here, with the
+ * engine's behavior: containers, math types, console variables and ParallelFor over a pool of worker threads.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+typedef int8_t int8;
+typedef uint8_t uint8;
+typedef int16_t int16;
+typedef uint16_t uint16;
+typedef int32_t int32;
+typedef uint32_t uint32;
+typedef int64_t int64;
+typedef uint64_t uint64;
+typedef char TCHAR;
+
+#define TEXT(x) x
+#define VERLETCLOTHCOMPONENT_API
+
+#if defined(_MSC_VER)
+	#define FORCEINLINE __forceinline
+#else
+	#define FORCEINLINE inline __attribute__((always_inline))
+#endif
+
+#ifndef PLATFORM_ENABLE_VECTORINTRINSICS
+	#define PLATFORM_ENABLE_VECTORINTRINSICS 1
+#endif
+
+#define check(expr) assert(expr)
+#define checkSlow(expr)
+
+#define INDEX_NONE (-1)
+#define SMALL_NUMBER (1.e-8f)
+#define KINDA_SMALL_NUMBER (1.e-4f)
+#define MAX_uint16 ((uint16)0xffff)
+#define MAX_flt (3.402823466e+38F)
+#define PI (3.1415926535897932f)
+
+template<typename T>
+FORCEINLINE T Align(T Val, uint64 Alignment)
+{
+	return (T)(((uint64)Val + Alignment - 1) & ~(Alignment - 1));
+}
+
+template<typename T>
+FORCEINLINE typename std::remove_reference<T>::type&& MoveTemp(T&& Obj)
+{
+	return static_cast<typename std::remove_reference<T>::type&&>(Obj);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Memory and math
+
+struct FMemory
+{
+	static void* Malloc(size_t Size, uint32 Alignment);
+	static void Free(void* Ptr);
+
+	static FORCEINLINE void* Memcpy(void* Dest, const void* Src, size_t Size) { return memcpy(Dest, Src, Size); }
+	static FORCEINLINE void Memzero(void* Dest, size_t Size) { memset(Dest, 0, Size); }
+};
+
+struct FMath
+{
+	template<typename T> static FORCEINLINE T Min(T A, T B) { return A < B ? A : B; }
+	template<typename T> static FORCEINLINE T Max(T A, T B) { return A > B ? A : B; }
+	template<typename T> static FORCEINLINE T Clamp(T X, T MinValue, T MaxValue) { return X < MinValue ? MinValue : (X < MaxValue ? X : MaxValue); }
+	template<typename T> static FORCEINLINE T Square(T A) { return A * A; }
+	template<typename T> static FORCEINLINE T Abs(T A) { return A >= (T)0 ? A : -A; }
+	template<typename T> static FORCEINLINE T DivideAndRoundUp(T Dividend, T Divisor) { return (Dividend + Divisor - 1) / Divisor; }
+	template<typename T, typename U> static FORCEINLINE T Lerp(const T& A, const T& B, const U& Alpha) { return (T)(A + (B - A) * Alpha); }
+
+	static FORCEINLINE float Sqrt(float Value) { return sqrtf(Value); }
+	static FORCEINLINE float InvSqrt(float Value) { return 1.0f / sqrtf(Value); }
+	static FORCEINLINE float Sin(float Value) { return sinf(Value); }
+	static FORCEINLINE float Cos(float Value) { return cosf(Value); }
+	static FORCEINLINE float Fmod(float X, float Y) { return fmodf(X, Y); }
+	static FORCEINLINE int32 TruncToInt(float Value) { return (int32)Value; }
+	static FORCEINLINE int32 FloorToInt(float Value) { return (int32)floorf(Value); }
+	static FORCEINLINE int32 RoundToInt(float Value) { return FloorToInt(Value + 0.5f); }
+	static FORCEINLINE bool IsNearlyEqual(float A, float B, float ErrorTolerance = SMALL_NUMBER) { return Abs(A - B) <= ErrorTolerance; }
+
+	static FORCEINLINE uint32 RoundUpToPowerOfTwo(uint32 Value)
+	{
+		uint32 Result = 1;
+		while (Result < Value)
+			Result <<= 1;
+		return Result;
+	}
+};
+
+struct FVector
+{
+	float X, Y, Z;
+
+	static const FVector ZeroVector;
+
+	FORCEINLINE FVector() {}
+	explicit FORCEINLINE FVector(float InF) : X(InF), Y(InF), Z(InF) {}
+	FORCEINLINE FVector(float InX, float InY, float InZ) : X(InX), Y(InY), Z(InZ) {}
+
+	FORCEINLINE FVector operator+(const FVector& V) const { return FVector(X + V.X, Y + V.Y, Z + V.Z); }
+	FORCEINLINE FVector operator-(const FVector& V) const { return FVector(X - V.X, Y - V.Y, Z - V.Z); }
+	FORCEINLINE FVector operator*(const FVector& V) const { return FVector(X * V.X, Y * V.Y, Z * V.Z); }
+	FORCEINLINE FVector operator*(float Scale) const { return FVector(X * Scale, Y * Scale, Z * Scale); }
+	FORCEINLINE FVector operator/(float Scale) const { const float RScale = 1.0f / Scale; return FVector(X * RScale, Y * RScale, Z * RScale); }
+	FORCEINLINE FVector operator-() const { return FVector(-X, -Y, -Z); }
+	FORCEINLINE FVector& operator+=(const FVector& V) { X += V.X; Y += V.Y; Z += V.Z; return *this; }
+	FORCEINLINE FVector& operator-=(const FVector& V) { X -= V.X; Y -= V.Y; Z -= V.Z; return *this; }
+	FORCEINLINE FVector& operator*=(float Scale) { X *= Scale; Y *= Scale; Z *= Scale; return *this; }
+
+	/** Cross product */
+	FORCEINLINE FVector operator^(const FVector& V) const { return FVector(Y * V.Z - Z * V.Y, Z * V.X - X * V.Z, X * V.Y - Y * V.X); }
+	/** Dot product */
+	FORCEINLINE float operator|(const FVector& V) const { return X * V.X + Y * V.Y + Z * V.Z; }
+
+	FORCEINLINE float operator[](int32 Index) const { return (&X)[Index]; }
+	FORCEINLINE float& operator[](int32 Index) { return (&X)[Index]; }
+
+	static FORCEINLINE FVector CrossProduct(const FVector& A, const FVector& B) { return A ^ B; }
+	static FORCEINLINE float DotProduct(const FVector& A, const FVector& B) { return A | B; }
+	static FORCEINLINE float DistSquared(const FVector& A, const FVector& B) { return (B - A).SizeSquared(); }
+	static FORCEINLINE float Dist(const FVector& A, const FVector& B) { return (B - A).Size(); }
+
+	FORCEINLINE float SizeSquared() const { return X * X + Y * Y + Z * Z; }
+	FORCEINLINE float Size() const { return FMath::Sqrt(SizeSquared()); }
+
+	FORCEINLINE FVector ComponentMin(const FVector& V) const { return FVector(FMath::Min(X, V.X), FMath::Min(Y, V.Y), FMath::Min(Z, V.Z)); }
+	FORCEINLINE FVector ComponentMax(const FVector& V) const { return FVector(FMath::Max(X, V.X), FMath::Max(Y, V.Y), FMath::Max(Z, V.Z)); }
+
+	FORCEINLINE bool IsNearlyZero(float Tolerance = KINDA_SMALL_NUMBER) const
+	{
+		return FMath::Abs(X) <= Tolerance && FMath::Abs(Y) <= Tolerance && FMath::Abs(Z) <= Tolerance;
+	}
+
+	FORCEINLINE bool Equals(const FVector& V, float Tolerance = KINDA_SMALL_NUMBER) const
+	{
+		return FMath::Abs(X - V.X) <= Tolerance && FMath::Abs(Y - V.Y) <= Tolerance && FMath::Abs(Z - V.Z) <= Tolerance;
+	}
+
+	FORCEINLINE FVector GetSafeNormal(float Tolerance = SMALL_NUMBER) const
+	{
+		const float SquareSum = SizeSquared();
+		if (SquareSum == 1.0f)
+			return *this;
+		if (SquareSum < Tolerance)
+			return ZeroVector;
+		return *this * FMath::InvSqrt(SquareSum);
+	}
+};
+
+FORCEINLINE FVector operator*(float Scale, const FVector& V)
+{
+	return V * Scale;
+}
+
+struct FVector2D
+{
+	float X, Y;
+
+	static const FVector2D ZeroVector;
+
+	FORCEINLINE FVector2D() {}
+	FORCEINLINE FVector2D(float InX, float InY) : X(InX), Y(InY) {}
+
+	FORCEINLINE FVector2D operator+(const FVector2D& V) const { return FVector2D(X + V.X, Y + V.Y); }
+	FORCEINLINE FVector2D operator-(const FVector2D& V) const { return FVector2D(X - V.X, Y - V.Y); }
+	FORCEINLINE FVector2D operator*(float Scale) const { return FVector2D(X * Scale, Y * Scale); }
+};
+
+struct FIntVector
+{
+	int32 X, Y, Z;
+
+	FORCEINLINE FIntVector() {}
+	FORCEINLINE FIntVector(int32 InX, int32 InY, int32 InZ) : X(InX), Y(InY), Z(InZ) {}
+
+	FORCEINLINE bool operator==(const FIntVector& Other) const { return X == Other.X && Y == Other.Y && Z == Other.Z; }
+	FORCEINLINE bool operator!=(const FIntVector& Other) const { return !(*this == Other); }
+};
+
+struct FColor
+{
+	uint8 B, G, R, A;
+
+	static const FColor White;
+
+	FORCEINLINE FColor() {}
+	FORCEINLINE FColor(uint8 InR, uint8 InG, uint8 InB, uint8 InA = 255) : B(InB), G(InG), R(InR), A(InA) {}
+};
+
+struct FPlane : public FVector
+{
+	float W;
+
+	FORCEINLINE FPlane() {}
+	FORCEINLINE FPlane(const FVector& InNormal, float InW) : FVector(InNormal), W(InW) {}
+	FORCEINLINE FPlane(float InX, float InY, float InZ, float InW) : FVector(InX, InY, InZ), W(InW) {}
+};
+
+struct FQuat
+{
+	float X, Y, Z, W;
+
+	static const FQuat Identity;
+
+	FORCEINLINE FQuat() {}
+	FORCEINLINE FQuat(float InX, float InY, float InZ, float InW) : X(InX), Y(InY), Z(InZ), W(InW) {}
+
+	/** Rotation of Angle radians around a unit Axis */
+	FORCEINLINE FQuat(const FVector& Axis, float Angle)
+	{
+		const float HalfSin = FMath::Sin(0.5f * Angle);
+		X = Axis.X * HalfSin;
+		Y = Axis.Y * HalfSin;
+		Z = Axis.Z * HalfSin;
+		W = FMath::Cos(0.5f * Angle);
+	}
+
+	FORCEINLINE FVector RotateVector(const FVector& V) const
+	{
+		const FVector Q(X, Y, Z);
+		const FVector T = (Q ^ V) * 2.0f;
+		return V + (T * W) + (Q ^ T);
+	}
+
+	FORCEINLINE FVector UnrotateVector(const FVector& V) const
+	{
+		return FQuat(-X, -Y, -Z, W).RotateVector(V);
+	}
+
+	FORCEINLINE FVector GetAxisX() const { return RotateVector(FVector(1.0f, 0.0f, 0.0f)); }
+	FORCEINLINE FVector GetAxisY() const { return RotateVector(FVector(0.0f, 1.0f, 0.0f)); }
+	FORCEINLINE FVector GetAxisZ() const { return RotateVector(FVector(0.0f, 0.0f, 1.0f)); }
+
+	FORCEINLINE bool Equals(const FQuat& Q, float Tolerance = KINDA_SMALL_NUMBER) const
+	{
+		// Both signs are the same rotation
+		const bool bSame = FMath::Abs(X - Q.X) <= Tolerance && FMath::Abs(Y - Q.Y) <= Tolerance && FMath::Abs(Z - Q.Z) <= Tolerance && FMath::Abs(W - Q.W) <= Tolerance;
+		const bool bOpposite = FMath::Abs(X + Q.X) <= Tolerance && FMath::Abs(Y + Q.Y) <= Tolerance && FMath::Abs(Z + Q.Z) <= Tolerance && FMath::Abs(W + Q.W) <= Tolerance;
+		return bSame || bOpposite;
+	}
+};
+
+struct FBox
+{
+	FVector Min;
+	FVector Max;
+	uint8 IsValid;
+
+	FORCEINLINE FBox() {}
+	/** Empty box, FBox(0) */
+	explicit FORCEINLINE FBox(int32) : Min(0.0f), Max(0.0f), IsValid(0) {}
+	FORCEINLINE FBox(const FVector& InMin, const FVector& InMax) : Min(InMin), Max(InMax), IsValid(1) {}
+
+	FORCEINLINE FBox& operator+=(const FVector& Other)
+	{
+		Min = IsValid ? Min.ComponentMin(Other) : Other;
+		Max = IsValid ? Max.ComponentMax(Other) : Other;
+		IsValid = 1;
+		return *this;
+	}
+
+	FORCEINLINE FBox ExpandBy(float W) const
+	{
+		return FBox(Min - FVector(W), Max + FVector(W));
+	}
+
+	FORCEINLINE bool Intersect(const FBox& Other) const
+	{
+		return Min.X <= Other.Max.X && Max.X >= Other.Min.X
+			&& Min.Y <= Other.Max.Y && Max.Y >= Other.Min.Y
+			&& Min.Z <= Other.Max.Z && Max.Z >= Other.Min.Z;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Containers
+
+/** Default allocation policy, 16 byte aligned like the engine's allocator */
+struct FDefaultAllocator
+{
+	enum { Alignment = 16 };
+};
+
+template<uint32 InAlignment>
+struct TAlignedHeapAllocator
+{
+	enum { Alignment = InAlignment };
+};
+
+/** Inline storage is not kept standalone, elements always live on the heap */
+template<uint32 NumInlineElements>
+struct TInlineAllocator : public FDefaultAllocator
+{
+};
+
+namespace VerletClothStandalone
+{
+	/** Standard allocator over FMemory, aligned to at least Alignment */
+	template<typename T, uint32 Alignment>
+	struct TAlignedAllocator
+	{
+		typedef T value_type;
+
+		template<typename U>
+		struct rebind
+		{
+			typedef TAlignedAllocator<U, Alignment> other;
+		};
+
+		TAlignedAllocator() {}
+		template<typename U> TAlignedAllocator(const TAlignedAllocator<U, Alignment>&) {}
+
+		T* allocate(size_t Count)
+		{
+			const uint32 ElementAlignment = (uint32)alignof(T);
+			return (T*)FMemory::Malloc(Count * sizeof(T), Alignment > ElementAlignment ? Alignment : ElementAlignment);
+		}
+
+		void deallocate(T* Ptr, size_t)
+		{
+			FMemory::Free(Ptr);
+		}
+
+		template<typename U> bool operator==(const TAlignedAllocator<U, Alignment>&) const { return true; }
+		template<typename U> bool operator!=(const TAlignedAllocator<U, Alignment>&) const { return false; }
+	};
+
+	/** Storage of TArray elements, bools are wrapped so that elements are always addressable */
+	template<typename T>
+	struct TArrayElement
+	{
+		typedef T Type;
+	};
+
+	struct FBoolElement
+	{
+		bool Value;
+
+		FBoolElement() {}
+		FBoolElement(bool InValue) : Value(InValue) {}
+	};
+
+	template<>
+	struct TArrayElement<bool>
+	{
+		typedef FBoolElement Type;
+	};
+}
+
+/** Dynamic array with the engine's TArray interface, as far as the core uses it */
+template<typename T, typename Allocator = FDefaultAllocator>
+class TArray
+{
+	typedef typename VerletClothStandalone::TArrayElement<T>::Type ElementType;
+	typedef std::vector<ElementType, VerletClothStandalone::TAlignedAllocator<ElementType, Allocator::Alignment>> StorageType;
+
+	static_assert(sizeof(ElementType) == sizeof(T), "Wrapped elements must have the same layout");
+
+public:
+
+	TArray() {}
+	TArray(std::initializer_list<T> InitList) { for (const T& Element : InitList) Add(Element); }
+
+	FORCEINLINE int32 Num() const { return (int32)Storage.size(); }
+	FORCEINLINE T* GetData() { return reinterpret_cast<T*>(Storage.data()); }
+	FORCEINLINE const T* GetData() const { return reinterpret_cast<const T*>(Storage.data()); }
+	FORCEINLINE bool IsValidIndex(int32 Index) const { return Index >= 0 && Index < Num(); }
+	FORCEINLINE uint32 GetAllocatedSize() const { return (uint32)(Storage.capacity() * sizeof(ElementType)); }
+
+	FORCEINLINE T& operator[](int32 Index) { checkSlow(IsValidIndex(Index)); return GetData()[Index]; }
+	FORCEINLINE const T& operator[](int32 Index) const { checkSlow(IsValidIndex(Index)); return GetData()[Index]; }
+
+	FORCEINLINE T& Last(int32 IndexFromTheEnd = 0) { return GetData()[Num() - IndexFromTheEnd - 1]; }
+	FORCEINLINE const T& Last(int32 IndexFromTheEnd = 0) const { return GetData()[Num() - IndexFromTheEnd - 1]; }
+
+	FORCEINLINE T* begin() { return GetData(); }
+	FORCEINLINE T* end() { return GetData() + Num(); }
+	FORCEINLINE const T* begin() const { return GetData(); }
+	FORCEINLINE const T* end() const { return GetData() + Num(); }
+
+	int32 Add(const T& Item)
+	{
+		Storage.push_back(ElementType(Item));
+		return Num() - 1;
+	}
+
+	int32 Add(T&& Item)
+	{
+		Storage.push_back(ElementType(MoveTemp(Item)));
+		return Num() - 1;
+	}
+
+	int32 AddUninitialized(int32 Count = 1)
+	{
+		const int32 Index = Num();
+		Storage.resize(Storage.size() + Count);
+		return Index;
+	}
+
+	int32 AddZeroed(int32 Count = 1)
+	{
+		const int32 Index = AddUninitialized(Count);
+		ZeroElements(Index, Count);
+		return Index;
+	}
+
+	int32 AddDefaulted(int32 Count = 1)
+	{
+		const int32 Index = Num();
+		Storage.resize(Storage.size() + Count);
+		return Index;
+	}
+
+	void SetNumUninitialized(int32 NewNum, bool bAllowShrinking = true)
+	{
+		Storage.resize(NewNum);
+	}
+
+	void SetNumZeroed(int32 NewNum, bool bAllowShrinking = true)
+	{
+		const int32 OldNum = Num();
+		Storage.resize(NewNum);
+		if (NewNum > OldNum)
+			ZeroElements(OldNum, NewNum - OldNum);
+	}
+
+	void Init(const T& Element, int32 Number)
+	{
+		Storage.assign(Number, ElementType(Element));
+	}
+
+	void Reset(int32 NewSize = 0)
+	{
+		Storage.clear();
+		Storage.reserve(NewSize);
+	}
+
+	void Empty(int32 Slack = 0)
+	{
+		StorageType().swap(Storage);
+		Storage.reserve(Slack);
+	}
+
+	void Reserve(int32 Number)
+	{
+		Storage.reserve(Number);
+	}
+
+	int32 Find(const T& Item) const
+	{
+		for (int32 Index = 0; Index < Num(); ++Index)
+		{
+			if ((*this)[Index] == Item)
+				return Index;
+		}
+		return INDEX_NONE;
+	}
+
+	bool Contains(const T& Item) const
+	{
+		return Find(Item) != INDEX_NONE;
+	}
+
+	void RemoveAtSwap(int32 Index)
+	{
+		(*this)[Index] = MoveTemp(Last());
+		Storage.pop_back();
+	}
+
+	/** Sorts with operator< */
+	void Sort()
+	{
+		std::sort(begin(), end());
+	}
+
+	/** Binary heap with the smallest element first, like the engine's heap functions with TLess */
+	void HeapPush(const T& Item)
+	{
+		Add(Item);
+		std::push_heap(begin(), end(), &HeapGreater);
+	}
+
+	void HeapPop(T& OutItem, bool bAllowShrinking = true)
+	{
+		std::pop_heap(begin(), end(), &HeapGreater);
+		OutItem = MoveTemp(Last());
+		Storage.pop_back();
+	}
+
+private:
+
+	static bool HeapGreater(const T& A, const T& B)
+	{
+		return B < A;
+	}
+
+	void ZeroElements(int32 Index, int32 Count)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be zeroed");
+		FMemory::Memzero(GetData() + Index, Count * sizeof(T));
+	}
+
+	StorageType Storage;
+};
+
+/** Array of bits */
+template<typename Allocator = FDefaultAllocator>
+class TBitArray
+{
+public:
+
+	TBitArray() {}
+	TBitArray(bool bValue, int32 InNumBits) : Bits(InNumBits, bValue) {}
+
+	FORCEINLINE int32 Num() const { return (int32)Bits.size(); }
+	FORCEINLINE std::vector<bool>::reference operator[](int32 Index) { return Bits[Index]; }
+	FORCEINLINE bool operator[](int32 Index) const { return Bits[Index]; }
+
+private:
+
+	std::vector<bool> Bits;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Console variables
+
+enum EConsoleVariableFlags
+{
+	ECVF_Default = 0,
+	ECVF_SetByCode = 0,
+};
+
+class IConsoleVariable
+{
+public:
+
+	virtual ~IConsoleVariable() {}
+	virtual void Set(const TCHAR* InValue, EConsoleVariableFlags SetBy = ECVF_SetByCode) = 0;
+	virtual int32 GetInt() const = 0;
+	virtual float GetFloat() const = 0;
+
+	void Set(int32 InValue, EConsoleVariableFlags SetBy = ECVF_SetByCode);
+	void Set(float InValue, EConsoleVariableFlags SetBy = ECVF_SetByCode);
+};
+
+/** Registry of the console variables, they can only be set from code */
+class IConsoleManager
+{
+public:
+
+	static IConsoleManager& Get();
+
+	IConsoleVariable* FindConsoleVariable(const TCHAR* Name) const;
+	void Register(const TCHAR* Name, IConsoleVariable* Variable);
+
+private:
+
+	std::vector<std::pair<const TCHAR*, IConsoleVariable*>> Variables;
+};
+
+template<typename T>
+class TAutoConsoleVariable : public IConsoleVariable
+{
+public:
+
+	TAutoConsoleVariable(const TCHAR* Name, const T& DefaultValue, const TCHAR* Help, EConsoleVariableFlags Flags = ECVF_Default)
+		: Value(DefaultValue)
+	{
+		IConsoleManager::Get().Register(Name, this);
+	}
+
+	using IConsoleVariable::Set;
+
+	virtual void Set(const TCHAR* InValue, EConsoleVariableFlags SetBy = ECVF_SetByCode) override
+	{
+		Value = (T)atof(InValue);
+	}
+
+	virtual int32 GetInt() const override { return (int32)Value; }
+	virtual float GetFloat() const override { return (float)Value; }
+
+	T GetValueOnAnyThread() const { return Value; }
+	T GetValueOnGameThread() const { return Value; }
+
+private:
+
+	T Value;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Stats, compiled out like in a build without STATS
+
+#define DECLARE_STATS_GROUP(Description, GroupId, Category)
+#define DECLARE_CYCLE_STAT_EXTERN(Name, StatId, GroupId, API)
+#define DECLARE_DWORD_COUNTER_STAT_EXTERN(Name, StatId, GroupId, API)
+#define DECLARE_MEMORY_STAT_EXTERN(Name, StatId, GroupId, API)
+#define SCOPE_CYCLE_COUNTER(StatId)
+#define INC_DWORD_STAT(StatId)
+#define INC_DWORD_STAT_BY(StatId, Amount)
+
+//////////////////////////////////////////////////////////////////////////
+// Threading
+
+namespace VerletClothStandalone
+{
+	/** Threads ParallelFor runs on, the calling thread included. Defaults to the hardware thread count. */
+	void SetNumWorkerThreads(int32 NumThreads);
+	int32 GetNumWorkerThreads();
+
+	void ParallelForInternal(int32 Num, void (*Invoke)(void* Body, int32 Index), void* Body, bool bForceSingleThread);
+}
+
+/** Calls Body for every index from 0 to Num, spread over the worker threads. Nested calls run on the calling thread. */
+template<typename BodyType>
+void ParallelFor(int32 Num, BodyType&& Body, bool bForceSingleThread = false)
+{
+	typedef typename std::remove_reference<BodyType>::type FunctionType;
+	VerletClothStandalone::ParallelForInternal(Num, [](void* Function, int32 Index) { (*(FunctionType*)Function)(Index); }, (void*)&Body, bForceSingleThread);
+}
@@ -0,0 +1,133 @@
+// Copyright 2016 Moai Games, Inc. All Rights Reserved.
+
+/**
+ * Checks of the simulation kernels against hand computed expectations, with the scalar and the vectorized kernels.
+ * Usage: VerletClothKernelTests, returns non-zero when a check fails.
+ */
+
+#include "VerletClothComponentPluginPrivatePCH.h"
+#include "VerletClothKernels.h"
+
+#include <cstdio>
+
+namespace
+{
+	int32 NumFailed = 0;
+
+	void Check(bool bPassed, const char* Name, const char* Mode)
+	{
+		printf("%-48s %-6s %s\n", Name, Mode, bPassed ? "passed" : "FAILED");
+		if (!bPassed)
+		{
+			++NumFailed;
+		}
+	}
+
+	/**
+	 * Force on a still triangle tilted 45 degrees in a wind along +X, rising toward the wind direction.
+	 * The wind hits its upper side, drag and lift both push it down. Enough copies of the triangle are
+	 * given to go through the vectorized loop and the remainder loop. Winding of the odd ones is flipped.
+	 */
+	void ComputeTiltedTriangleForce(float Drag, float Lift, TArray<FVector>& OutForces)
+	{
+		FVerletClothParticles Particles;
+		Particles.Init(1, 3);
+		const FVector Corners[3] = { FVector(0.0f, 0.0f, 0.0f), FVector(0.0f, 1.0f, 0.0f), FVector(1.0f, 0.0f, 1.0f) };
+		for (int32 Idx = 0; Idx < 3; ++Idx)
+		{
+			Particles.SetPosition(Idx, Corners[Idx]);
+			Particles.SetSavedPosition(Idx, Corners[Idx]);
+			Particles.SetFree(Idx, true);
+		}
+
+		const int32 NumTriangles = 11;
+		TArray<int32> CornerA, CornerB, CornerC;
+		for (int32 Idx = 0; Idx < NumTriangles; ++Idx)
+		{
+			CornerA.Add(0);
+			CornerB.Add(Idx % 2 ? 2 : 1);
+			CornerC.Add(Idx % 2 ? 1 : 2);
+		}
+
+		const float WindX[3] = { 10.0f, 10.0f, 10.0f };
+		const float WindY[3] = { 0.0f, 0.0f, 0.0f };
+		const float WindZ[3] = { 0.0f, 0.0f, 0.0f };
+		TArray<float> ForceX, ForceY, ForceZ;
+		ForceX.AddZeroed(NumTriangles);
+		ForceY.AddZeroed(NumTriangles);
+		ForceZ.AddZeroed(NumTriangles);
+		VerletClothKernels::ComputeAerodynamicForces(Particles, CornerA.GetData(), CornerB.GetData(), CornerC.GetData(), NumTriangles,
+			WindX, WindY, WindZ, 1.0f / 60.0f, Drag, Lift, ForceX.GetData(), ForceY.GetData(), ForceZ.GetData());
+
+		OutForces.Reset();
+		for (int32 Idx = 0; Idx < NumTriangles; ++Idx)
+			OutForces.Add(FVector(ForceX[Idx], ForceY[Idx], ForceZ[Idx]));
+	}
+
+	bool AllNear(const TArray<FVector>& Forces, const FVector& Expected)
+	{
+		for (int32 Idx = 0; Idx < Forces.Num(); ++Idx)
+		{
+			if ((Forces[Idx] - Expected).Size() > 1.0e-3f)
+				return false;
+		}
+		return true;
+	}
+
+	void TestAerodynamicForces(const char* Mode)
+	{
+		// Normal | Wind is -10 / sqrt(2), with the normal (-1, 0, 1) / sqrt(2) the pressure pushes along (1, 0, -1) * 5
+		TArray<FVector> Forces;
+		ComputeTiltedTriangleForce(1.0f, 0.0f, Forces);
+		Check(AllNear(Forces, FVector(5.0f, 0.0f, -5.0f)), "Aerodynamics: drag pushes along the normal", Mode);
+
+		// Lift is the part of the pressure across the wind, down here and without any component along the wind
+		ComputeTiltedTriangleForce(0.0f, 1.0f, Forces);
+		Check(AllNear(Forces, FVector(0.0f, 0.0f, -5.0f)), "Aerodynamics: lift pushes across the wind", Mode);
+
+		ComputeTiltedTriangleForce(1.0f, 1.0f, Forces);
+		Check(AllNear(Forces, FVector(5.0f, 0.0f, -10.0f)), "Aerodynamics: drag and lift add up", Mode);
+	}
+
+	void TestIntegrateBounds(const char* Mode)
+	{
+		// Far from the origin, where the padding particles sit, with a pinned first line and a remainder after the last full block
+		FVerletClothParticles Particles;
+		Particles.Init(3, 5);
+		for (int32 Idx = 0; Idx < Particles.NumParticles; ++Idx)
+		{
+			const bool bFree = Idx >= Particles.NumPointsPerLine;
+			const FVector Position(1000.0f + Idx, 2000.0f - Idx * 2.0f, 500.0f);
+			Particles.SetPosition(Idx, Position);
+			Particles.SetSavedPosition(Idx, bFree ? Position - FVector(0.0f, 0.0f, Idx * 0.1f) : FVector::ZeroVector);
+			Particles.SetFree(Idx, bFree);
+		}
+		VerletClothKernels::SetAcceleration(Particles, FVector(0.0f, 0.0f, -980.0f));
+
+		float MaxSquaredStep;
+		const FBox Bounds = VerletClothKernels::Integrate(Particles, 0.99f, 1.0f / (60.0f * 60.0f), MaxSquaredStep);
+
+		FBox Expected(0);
+		for (int32 Idx = Particles.NumPointsPerLine; Idx < Particles.NumParticles; ++Idx)
+			Expected += Particles.GetPosition(Idx);
+		Check(Bounds.IsValid && Bounds.Min.Equals(Expected.Min) && Bounds.Max.Equals(Expected.Max), "Integrate: bounds of the free particles", Mode);
+		// Up to the rounding of positions this far out
+		const float ExpectedStep = VerletClothKernels::GetMaxSquaredStep(Particles);
+		Check(FMath::IsNearlyEqual(MaxSquaredStep, ExpectedStep, ExpectedStep * 1.0e-3f), "Integrate: longest step of the free particles", Mode);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	IConsoleVariable* SimdVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("verletcloth.Simd"));
+	check(SimdVariable != nullptr);
+
+	for (int32 bSimd = 0; bSimd <= 1; ++bSimd)
+	{
+		SimdVariable->Set(bSimd);
+		TestAerodynamicForces(bSimd ? "Simd" : "Scalar");
+		TestIntegrateBounds(bSimd ? "Simd" : "Scalar");
+	}
+
+	return NumFailed == 0 ? 0 : 1;
+}